@@ -0,0 +1,785 @@
+/*
+
+MIT No Attribution
+
+Copyright (c) 2023 Mika Tuupola
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+-cut-
+
+Host benchmark for the effects. Runs the same animate and render loop
+as demo_task in main.c against an in-memory framebuffer.
+
+With -c, -r, -f or -p the benchmark runs in deterministic verify mode
+instead. The rand() calls are seeded and every frame is checksummed,
+compared against a reference file, compared against the floating point
+reference kernels in reference.c or written out as a PPM image.
+
+SPDX-License-Identifier: MIT-0
+
+*/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <string.h>
+#include <time.h>
+#include <hagl.h>
+
+#include "reference.h"
+#include "dirty.h"
+#include "hud.h"
+#include "indexed.h"
+#include "strip.h"
+#include "arena.h"
+#include "asset.h"
+#include "cache.h"
+#include "governor.h"
+#include "fixed.h"
+
+#include "metaballs.h"
+#include "plasma.h"
+#include "rotozoom.h"
+#include "deform.h"
+#include "sineplasma.h"
+
+typedef struct {
+    const char *name;
+    void (*init)();
+    void (*animate)();
+    void (*render)(hagl_backend_t const *display);
+    void (*render_rows)(hagl_backend_t const *display, int16_t y0, int16_t y1);
+    size_t (*arena_size)();
+    void (*scale)(uint8_t size);
+} effect_t;
+
+/* Pixel size can be changed at runtime only when built with the governor. */
+#ifdef CONFIG_EFFECTS_GOVERNOR
+#define GOVERNED(scale) (scale)
+#else
+#define GOVERNED(scale) NULL
+#endif /* CONFIG_EFFECTS_GOVERNOR */
+
+static const effect_t effects[] = {
+    { "metaballs", metaballs_init, metaballs_animate, metaballs_render, metaballs_render_rows, NULL, GOVERNED(metaballs_scale) },
+    { "plasma", plasma_init, plasma_animate, plasma_render, plasma_render_rows, plasma_arena_size, NULL },
+    { "rotozoom", rotozoom_init, rotozoom_animate, rotozoom_render, rotozoom_render_rows, rotozoom_arena_size, GOVERNED(rotozoom_scale) },
+    { "deform", deform_init, deform_animate, deform_render, deform_render_rows, deform_arena_size, NULL },
+    { "sineplasma", sineplasma_init, sineplasma_animate, sineplasma_render, sineplasma_render_rows, sineplasma_arena_size, NULL },
+};
+
+#ifdef CONFIG_EFFECTS_FIXED_POINT
+static const char *MATH = "fixed";
+#else
+static const char *MATH = "float";
+#endif /* CONFIG_EFFECTS_FIXED_POINT */
+
+/* When non zero frames are rendered in bands of this height. */
+static uint16_t band_height = 0;
+
+/* When non zero frames are rendered in strips of this height. */
+static uint16_t strip_height = 0;
+static hagl_backend_t *strips;
+
+/* When set frames are rendered as palette indices and expanded by flush. */
+static bool indexed = false;
+
+/*
+ * Render one frame. With bands enabled the bands are rendered bottom
+ * up to make sure effects do not depend on the order of bands. With
+ * strips enabled each strip is sent to the display as soon as it has
+ * been rendered, alternating between the strip buffers.
+ */
+static void
+render(const effect_t *effect, hagl_backend_t const *display)
+{
+    if (indexed) {
+        /* Previous frame has been flushed already. */
+        indexed_commit();
+    }
+
+    if (strip_height) {
+        for (uint16_t i = 0; i < strip_count(); i++) {
+            int16_t y0, y1;
+            strip_begin(i % STRIP_SLOTS, i, &y0, &y1);
+            effect->render_rows(strips, y0, y1);
+            strip_send(i % STRIP_SLOTS);
+        }
+        return;
+    }
+
+    if (0 == band_height) {
+        effect->render(display);
+        return;
+    }
+
+    const uint16_t bands = (DISPLAY_HEIGHT + band_height - 1) / band_height;
+    for (int16_t band = bands - 1; band >= 0; band--) {
+        const int16_t y0 = band * band_height;
+        const int16_t y1 = y0 + band_height < DISPLAY_HEIGHT ? y0 + band_height : DISPLAY_HEIGHT;
+        effect->render_rows(display, y0, y1);
+    }
+}
+
+static const uint8_t NUM_EFFECTS = sizeof(effects) / sizeof(effect_t);
+
+/*
+ * Heap accounting. The binary is linked with --wrap so that every
+ * allocation done by the effects passes through here.
+ */
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t nmemb, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+void __real_free(void *ptr);
+
+static size_t heap_current;
+static size_t heap_peak;
+
+typedef union {
+    size_t size;
+    max_align_t align;
+} heap_header_t;
+
+static void *
+heap_track(heap_header_t *header, size_t size)
+{
+    if (!header) {
+        return NULL;
+    }
+    header->size = size;
+    heap_current += size;
+    if (heap_current > heap_peak) {
+        heap_peak = heap_current;
+    }
+    return header + 1;
+}
+
+void *
+__wrap_malloc(size_t size)
+{
+    return heap_track(__real_malloc(sizeof(heap_header_t) + size), size);
+}
+
+void *
+__wrap_calloc(size_t nmemb, size_t size)
+{
+    heap_header_t *header = __real_calloc(1, sizeof(heap_header_t) + nmemb * size);
+    return heap_track(header, nmemb * size);
+}
+
+void
+__wrap_free(void *ptr)
+{
+    if (!ptr) {
+        return;
+    }
+    heap_header_t *header = (heap_header_t *) ptr - 1;
+    heap_current -= header->size;
+    __real_free(header);
+}
+
+void *
+__wrap_realloc(void *ptr, size_t size)
+{
+    if (!ptr) {
+        return __wrap_malloc(size);
+    }
+    heap_header_t *header = (heap_header_t *) ptr - 1;
+    heap_current -= header->size;
+    return heap_track(__real_realloc(header, sizeof(heap_header_t) + size), size);
+}
+
+static uint32_t crc_table[256];
+
+static void
+crc32_init()
+{
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t crc = i;
+        for (uint8_t j = 0; j < 8; j++) {
+            crc = (crc & 1) ? (crc >> 1) ^ 0xedb88320 : crc >> 1;
+        }
+        crc_table[i] = crc;
+    }
+}
+
+static uint32_t
+crc32(const uint8_t *data, size_t size)
+{
+    uint32_t crc = 0xffffffff;
+    while (size--) {
+        crc = crc_table[(crc ^ *(data++)) & 0xff] ^ (crc >> 8);
+    }
+    return crc ^ 0xffffffff;
+}
+
+static int
+write_ppm(const char *dir, const char *name, uint32_t frame, hagl_color_t const *buffer)
+{
+    char filename[256];
+    snprintf(filename, sizeof(filename), "%s/%s-%03dx%03d-%05u.ppm", dir, name, DISPLAY_WIDTH, DISPLAY_HEIGHT, frame);
+
+    FILE *file = fopen(filename, "wb");
+    if (!file) {
+        perror(filename);
+        return -1;
+    }
+
+    fprintf(file, "P6\n%d %d\n255\n", DISPLAY_WIDTH, DISPLAY_HEIGHT);
+    for (uint32_t i = 0; i < DISPLAY_WIDTH * DISPLAY_HEIGHT; i++) {
+        uint8_t rgb[3];
+        reference_rgb(buffer[i], &rgb[0], &rgb[1], &rgb[2]);
+        fwrite(rgb, 1, 3, file);
+    }
+    fclose(file);
+
+    return 0;
+}
+
+/*
+ * Read expected checksum of given effect and frame from a reference file
+ * written earlier with -c. Returns 0 when the frame is not listed.
+ */
+static int
+read_crc(FILE *file, const char *name, uint32_t frame, uint32_t *crc)
+{
+    char line[128];
+    char effect[32];
+    uint32_t number;
+
+    rewind(file);
+    while (fgets(line, sizeof(line), file)) {
+        if (3 == sscanf(line, "%31s %u %x", effect, &number, crc)) {
+            if (0 == strcmp(effect, name) && number == frame) {
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+/* True if any color channel differs by more than max_delta. */
+static bool
+differs(hagl_color_t actual, hagl_color_t expected, uint8_t max_delta)
+{
+    uint8_t a[3], e[3];
+
+    reference_rgb(actual, &a[0], &a[1], &a[2]);
+    reference_rgb(expected, &e[0], &e[1], &e[2]);
+    for (uint8_t i = 0; i < 3; i++) {
+        if (abs(a[i] - e[i]) > max_delta) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+ * Count pixels inside the clip window which differ from all of the
+ * reference choices by more than max_delta in any color channel.
+ */
+static uint32_t
+compare(hagl_color_t const *actual, hagl_color_t *const expected[REFERENCE_CHOICES], hagl_window_t const *clip, uint8_t max_delta)
+{
+    uint32_t errors = 0;
+
+    for (uint16_t y = clip->y0; y <= clip->y1; y++) {
+        for (uint16_t x = clip->x0; x <= clip->x1; x++) {
+            const uint32_t i = DISPLAY_WIDTH * y + x;
+            uint8_t choice = 0;
+            while (choice < REFERENCE_CHOICES && differs(actual[i], expected[choice][i], max_delta)) {
+                choice++;
+            }
+            if (choice == REFERENCE_CHOICES) {
+                errors++;
+            }
+        }
+    }
+    return errors;
+}
+
+static uint64_t
+nanotime()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void
+report(const char *name, uint32_t count, uint64_t fixed, uint64_t floating, double error, const char *unit)
+{
+    printf(
+        "%-10s  %8.2f ns fixed  %8.2f ns float  max error %.3g%s\n",
+        name, (double) fixed / count, (double) floating / count, error, unit
+    );
+}
+
+/*
+ * Time the integer math in fixed.c against the floating point functions
+ * it replaces and report the largest error against double precision.
+ */
+static void
+compare_math(uint32_t count)
+{
+    volatile int64_t sink = 0;
+    uint64_t start, fixed, floating;
+    double error;
+
+    start = nanotime();
+    for (uint32_t i = 0; i < count; i++) {
+        sink += fixed_sin(i * 40503);
+    }
+    fixed = nanotime() - start;
+    start = nanotime();
+    for (uint32_t i = 0; i < count; i++) {
+        sink += sinf((uint16_t) (i * 40503) * (float) (2 * M_PI / FIXED_TURN)) * FIXED_SINE_ONE;
+    }
+    floating = nanotime() - start;
+    error = 0;
+    for (uint32_t i = 0; i < FIXED_TURN; i++) {
+        error = fmax(error, fabs(fixed_sin(i) - sin(i * 2 * M_PI / FIXED_TURN) * FIXED_SINE_ONE));
+    }
+    report("sin", count, fixed, floating, error, " / 32768");
+
+    start = nanotime();
+    for (uint32_t i = 0; i < count; i++) {
+        sink += fixed_atan2((int16_t) (i * 40503), (int16_t) (i * 2654435761u >> 16));
+    }
+    fixed = nanotime() - start;
+    start = nanotime();
+    for (uint32_t i = 0; i < count; i++) {
+        sink += atan2f((int16_t) (i * 40503), (int16_t) (i * 2654435761u >> 16)) * (float) (FIXED_TURN / (2 * M_PI));
+    }
+    floating = nanotime() - start;
+    error = 0;
+    for (int32_t y = -256; y <= 256; y++) {
+        for (int32_t x = -256; x <= 256; x++) {
+            const double angle = atan2(y, x) * FIXED_TURN / (2 * M_PI);
+            error = fmax(error, fabs(remainder(fixed_atan2(y, x) - angle, FIXED_TURN)));
+        }
+    }
+    report("atan2", count, fixed, floating, error, " / 65536 turn");
+
+    start = nanotime();
+    for (uint32_t i = 0; i < count; i++) {
+        sink += fixed_isqrt(i * 2654435761u);
+    }
+    fixed = nanotime() - start;
+    start = nanotime();
+    for (uint32_t i = 0; i < count; i++) {
+        sink += (uint16_t) sqrtf(i * 2654435761u);
+    }
+    floating = nanotime() - start;
+    error = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        const uint32_t n = i * 2654435761u;
+        error = fmax(error, fabs(fixed_isqrt(n) - floor(sqrt(n))));
+    }
+    report("isqrt", count, fixed, floating, error, "");
+
+    start = nanotime();
+    for (uint32_t i = 0; i < count; i++) {
+        sink += fixed_reciprocal(i | 2);
+    }
+    fixed = nanotime() - start;
+    start = nanotime();
+    for (uint32_t i = 0; i < count; i++) {
+        sink += (uint32_t) (4294967296.0f / (i | 2));
+    }
+    floating = nanotime() - start;
+    error = 0;
+    for (uint32_t i = 2; i < (1 << 15); i++) {
+        const double exact = 4294967296.0 / i;
+        error = fmax(error, fabs(fixed_reciprocal(i) - exact) / exact);
+    }
+    report("reciprocal", count, fixed, floating, error, " relative");
+}
+
+/*
+ * Render rotozoom at every whole degree with the zoom held at its
+ * largest and report the time per frame at each angle. Cost of reading
+ * the texture should not depend on the angle.
+ */
+static void
+sweep(hagl_backend_t const *display, uint32_t frames, const char *layout)
+{
+    const effect_t *effect = NULL;
+    double fastest = 0, slowest = 0, total = 0;
+    uint16_t fastest_angle = 0, slowest_angle = 0;
+
+    for (uint8_t i = 0; i < NUM_EFFECTS; i++) {
+        if (0 == strcmp("rotozoom", effects[i].name)) {
+            effect = &effects[i];
+        }
+    }
+
+    effect->init(display);
+
+    for (uint16_t angle = 0; angle < 360; angle++) {
+        rotozoom_rotate(angle);
+
+        const uint64_t start = nanotime();
+        for (uint32_t frame = 0; frame < frames; frame++) {
+            render(effect, display);
+        }
+        const double ns = (double) (nanotime() - start) / frames;
+
+        if (0 == angle || ns < fastest) {
+            fastest = ns;
+            fastest_angle = angle;
+        }
+        if (ns > slowest) {
+            slowest = ns;
+            slowest_angle = angle;
+        }
+        total += ns;
+
+        printf("%3dx%-3d  %s  %-6s  %3d degrees  %12.0f ns/frame\n", DISPLAY_WIDTH, DISPLAY_HEIGHT, MATH, layout, angle, ns);
+    }
+
+    printf(
+        "%3dx%-3d  %s  %-6s  %12.0f ns/frame average  fastest %.0f at %d  slowest %.0f at %d  slowest / fastest %.2f\n",
+        DISPLAY_WIDTH, DISPLAY_HEIGHT, MATH, layout, total / 360, fastest, fastest_angle, slowest, slowest_angle, slowest / fastest
+    );
+
+    arena_reset();
+}
+
+static void
+usage(const char *name)
+{
+    fprintf(stderr, "usage: %s [-n frames] [-e effect] [-s seed] [-b height] [-t height] [-d] [-i] [-g fps] [-m] [-z] [-a] [-l file] [-c] [-r file] [-f] [-p dir]\n", name);
+    fprintf(stderr, "  -n frames  number of frames to render per effect\n");
+    fprintf(stderr, "  -e effect  run only the given effect\n");
+    fprintf(stderr, "  -s seed    seed for rand(), default 1\n");
+    fprintf(stderr, "  -b height  render in bands of given height, bottom band first\n");
+    fprintf(stderr, "  -t height  render in strips of given height, multiple of %d\n", STRIP_ALIGN);
+    fprintf(stderr, "  -d         flush only changed rows and report bytes per flush\n");
+    fprintf(stderr, "  -i         render into an eight bit indexed back buffer\n");
+    fprintf(stderr, "  -g fps     adapt render scale to given frame rate and report time at each scale\n");
+    fprintf(stderr, "  -m         compare integer math against floating point and exit\n");
+    fprintf(stderr, "  -z         store textures in tiles instead of row by row\n");
+    fprintf(stderr, "  -a         time rotozoom at every angle and exit\n");
+    fprintf(stderr, "  -l file    keep generated tables in a cache file\n");
+    fprintf(stderr, "  -c         print checksum of every frame\n");
+    fprintf(stderr, "  -r file    verify frame checksums against reference file\n");
+    fprintf(stderr, "  -f         verify frames against the floating point reference\n");
+    fprintf(stderr, "  -p dir     write every frame as PPM image to dir\n");
+}
+
+/*
+ * Renders frames in deterministic mode and checks them. Returns number
+ * of frames which failed verification.
+ */
+static uint32_t
+verify(hagl_backend_t *display, const effect_t *effect, uint32_t frames, uint32_t seed, bool checksum, FILE *crcs, bool floating, const char *dir)
+{
+    /* Indexed frames are checked after flush has expanded them. */
+    hagl_backend_t const *output = indexed ? indexed_target(display) : display;
+    hagl_color_t *buffer = (hagl_color_t *) output->buffer;
+    hagl_color_t *expected[REFERENCE_CHOICES] = { NULL };
+    reference_t const *reference = NULL;
+    uint32_t failed = 0;
+
+    if (floating) {
+        reference = reference_find(effect->name);
+        for (uint8_t i = 0; i < REFERENCE_CHOICES; i++) {
+            expected[i] = calloc(DISPLAY_WIDTH * DISPLAY_HEIGHT, sizeof(hagl_color_t));
+        }
+        reference->init(seed);
+    }
+
+    srand(seed);
+    indexed_palette(NULL, 0);
+    effect->init(display);
+
+    for (uint32_t frame = 0; frame < frames; frame++) {
+        effect->animate();
+        render(effect, display);
+        if (indexed) {
+            hagl_flush(display);
+        }
+
+        uint32_t crc = crc32(output->buffer, DISPLAY_WIDTH * DISPLAY_HEIGHT * sizeof(hagl_color_t));
+
+        if (checksum) {
+            printf("%s %u %08x\n", effect->name, frame, crc);
+        }
+
+        if (crcs) {
+            uint32_t wanted;
+            if (!read_crc(crcs, effect->name, frame, &wanted)) {
+                /* Reference file covers fewer frames, stop checking. */
+                crcs = NULL;
+            } else if (wanted != crc) {
+                printf("%3dx%-3d  %-10s  frame %u checksum %08x, expected %08x\n",
+                    DISPLAY_WIDTH, DISPLAY_HEIGHT, effect->name, frame, crc, wanted);
+                failed++;
+            }
+        }
+
+        if (reference) {
+            reference->frame(expected, &display->clip);
+            uint32_t errors = compare(buffer, expected, &display->clip, reference->max_delta);
+            uint32_t pixels = (display->clip.x1 - display->clip.x0 + 1) * (display->clip.y1 - display->clip.y0 + 1);
+            if (errors > pixels * reference->max_error) {
+                printf("%3dx%-3d  %-10s  frame %u differs from reference in %u of %u pixels\n",
+                    DISPLAY_WIDTH, DISPLAY_HEIGHT, effect->name, frame, errors, pixels);
+                failed++;
+            }
+        }
+
+        if (dir) {
+            write_ppm(dir, effect->name, frame, buffer);
+        }
+    }
+
+    arena_reset();
+
+    if (reference) {
+        if (reference->close) {
+            reference->close();
+        }
+        for (uint8_t i = 0; i < REFERENCE_CHOICES; i++) {
+            free(expected[i]);
+        }
+    }
+
+    return failed;
+}
+
+int
+main(int argc, char *argv[])
+{
+    uint32_t frames = 500;
+    uint32_t seed = 1;
+    const char *only = NULL;
+    bool checksum = false;
+    bool floating = false;
+    const char *reference = NULL;
+    const char *dir = NULL;
+    bool tracking = false;
+    uint16_t target = 0;
+    bool math = false;
+    uint8_t layout = ASSET_LINEAR;
+    bool sweeping = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (0 == strcmp(argv[i], "-n") && i + 1 < argc) {
+            frames = strtoul(argv[++i], NULL, 10);
+        } else if (0 == strcmp(argv[i], "-e") && i + 1 < argc) {
+            only = argv[++i];
+        } else if (0 == strcmp(argv[i], "-s") && i + 1 < argc) {
+            seed = strtoul(argv[++i], NULL, 10);
+        } else if (0 == strcmp(argv[i], "-b") && i + 1 < argc) {
+            band_height = strtoul(argv[++i], NULL, 10);
+        } else if (0 == strcmp(argv[i], "-t") && i + 1 < argc) {
+            strip_height = strtoul(argv[++i], NULL, 10);
+            if (0 == strip_height || strip_height % STRIP_ALIGN) {
+                usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+        } else if (0 == strcmp(argv[i], "-d")) {
+            tracking = true;
+        } else if (0 == strcmp(argv[i], "-i")) {
+#ifndef CONFIG_EFFECTS_INDEXED
+            fprintf(stderr, "-i needs a build with CONFIG_EFFECTS_INDEXED\n");
+            return EXIT_FAILURE;
+#endif /* CONFIG_EFFECTS_INDEXED */
+            indexed = true;
+        } else if (0 == strcmp(argv[i], "-g") && i + 1 < argc) {
+            target = strtoul(argv[++i], NULL, 10);
+#ifndef CONFIG_EFFECTS_GOVERNOR
+            fprintf(stderr, "-g needs a build with CONFIG_EFFECTS_GOVERNOR\n");
+            return EXIT_FAILURE;
+#endif /* CONFIG_EFFECTS_GOVERNOR */
+            if (0 == target) {
+                usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+        } else if (0 == strcmp(argv[i], "-m")) {
+            math = true;
+        } else if (0 == strcmp(argv[i], "-z")) {
+            layout = ASSET_TILED;
+        } else if (0 == strcmp(argv[i], "-a")) {
+            sweeping = true;
+        } else if (0 == strcmp(argv[i], "-l") && i + 1 < argc) {
+            if (!cache_init(argv[++i])) {
+                perror(argv[i]);
+                return EXIT_FAILURE;
+            }
+        } else if (0 == strcmp(argv[i], "-c")) {
+            checksum = true;
+        } else if (0 == strcmp(argv[i], "-r") && i + 1 < argc) {
+            reference = argv[++i];
+        } else if (0 == strcmp(argv[i], "-f")) {
+            floating = true;
+        } else if (0 == strcmp(argv[i], "-p") && i + 1 < argc) {
+            dir = argv[++i];
+        } else {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (math) {
+        compare_math(frames * 10000);
+        return EXIT_SUCCESS;
+    }
+
+    bool verifying = checksum || floating || reference || dir;
+    FILE *crcs = NULL;
+    uint32_t failed = 0;
+
+    if (reference) {
+        crcs = fopen(reference, "r");
+        if (!crcs) {
+            perror(reference);
+            return EXIT_FAILURE;
+        }
+    }
+
+    crc32_init();
+
+    /* Same as main.c, one arena sized for the largest effect. */
+    size_t size = 0;
+    for (uint8_t i = 0; i < NUM_EFFECTS; i++) {
+        if (effects[i].arena_size && effects[i].arena_size() > size) {
+            size = effects[i].arena_size();
+        }
+    }
+    arena_init(size);
+
+    hagl_backend_t *display = hagl_init();
+
+    if (tracking) {
+        display = dirty_init(display);
+    }
+
+    /* Same clip window main.c uses. Top and bottom are reserved for texts. */
+    hagl_set_clip(display, 0, HUD_HEIGHT, DISPLAY_WIDTH - 1, DISPLAY_HEIGHT - HUD_HEIGHT - 1);
+
+    if (strip_height) {
+        strips = strip_init(display, strip_height);
+    }
+
+    /* Palette of the effect covers the clip window, set it first. */
+    if (indexed) {
+        display = indexed_init(display);
+    }
+
+    /* Same as main.c, textures in the colors of the final backend. */
+    asset_init(display, layout);
+
+    if (sweeping) {
+        sweep(display, frames, ASSET_TILED == layout ? "tiled" : "linear");
+        hagl_close(display);
+        return EXIT_SUCCESS;
+    }
+
+    /* Arena, textures and backend buffers, allocated once like on the device. */
+    if (!verifying) {
+        printf("%3dx%-3d  %s  %-10s  %8zu bytes heap\n", DISPLAY_WIDTH, DISPLAY_HEIGHT, MATH, "startup", heap_current);
+    }
+
+    for (uint8_t i = 0; i < NUM_EFFECTS; i++) {
+        const effect_t *effect = &effects[i];
+
+        if (only && strcmp(only, effect->name)) {
+            continue;
+        }
+
+        hagl_clear(display);
+
+        if (verifying) {
+            failed += verify(display, effect, frames, seed, checksum, crcs, floating, dir);
+            continue;
+        }
+
+        /* Count only what the effect itself allocates. */
+        size_t heap_before = heap_current;
+        heap_peak = heap_current;
+
+        uint64_t start = nanotime();
+        indexed_palette(NULL, 0);
+        effect->init(display);
+        uint64_t init = nanotime() - start;
+
+        uint64_t bytes = 0;
+        governor_t governor;
+        const bool governing = target && effect->scale;
+
+        if (governing) {
+            governor_init(&governor, target, GOVERNOR_MIN_SCALE);
+            effect->scale(governor.scale);
+        }
+
+        start = nanotime();
+        for (uint32_t frame = 0; frame < frames; frame++) {
+            effect->animate();
+            const uint64_t rendering = nanotime();
+            render(effect, display);
+            if (governing) {
+                /* Same as main.c, only render time is governed. */
+                effect->scale(governor_update(&governor, (nanotime() - rendering) / 1000));
+            }
+            if (tracking || indexed) {
+                bytes += hagl_flush(display);
+            }
+        }
+        uint64_t elapsed = nanotime() - start;
+
+        size_t peak = heap_peak - heap_before;
+        size_t used = arena_used();
+
+        arena_reset();
+
+        double ns = (double) elapsed / frames;
+        double pixels = (double) DISPLAY_WIDTH * DISPLAY_HEIGHT * frames / (elapsed / 1e9);
+
+        printf(
+            "%3dx%-3d  %s  %-10s  %6u frames  %12.0f ns/frame  %8.2f Mpixels/s  %8.0f us init  %8zu bytes peak heap  %8zu bytes arena",
+            DISPLAY_WIDTH, DISPLAY_HEIGHT, MATH, effect->name, frames, ns, pixels / 1e6, init / 1e3, peak, used
+        );
+        if (tracking || indexed) {
+            printf("  %8.0f bytes/flush", (double) bytes / frames);
+        }
+        if (governing) {
+            printf("  scale %d", governor.scale);
+            for (uint8_t scale = GOVERNOR_MIN_SCALE; scale <= GOVERNOR_MAX_SCALE; scale++) {
+                printf("  %d: %3d%%", scale, governor_share(&governor, scale));
+            }
+        }
+        printf("\n");
+    }
+
+    hagl_close(display);
+
+    if (crcs) {
+        fclose(crcs);
+    }
+
+    if (failed) {
+        printf("%3dx%-3d  %u frames failed verification\n", DISPLAY_WIDTH, DISPLAY_HEIGHT, failed);
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,317 @@
+/*
+
+MIT No Attribution
+
+Copyright (c) 2023 Mika Tuupola
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+-cut-
+
+In-memory framebuffer backend. Public functions clip exactly like HAGL
+does and then call the backend through function pointers so that the
+per pixel overhead is comparable to the real HAL.
+
+SPDX-License-Identifier: MIT-0
+
+*/
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "hagl.h"
+
+static hagl_backend_t backend;
+
+static void
+put_pixel(void *self, int16_t x0, int16_t y0, hagl_color_t color)
+{
+    hagl_backend_t *display = self;
+    hagl_color_t *ptr = (hagl_color_t *) display->buffer;
+    ptr[display->width * y0 + x0] = color;
+}
+
+static hagl_color_t
+get_pixel(void *self, int16_t x0, int16_t y0)
+{
+    hagl_backend_t *display = self;
+    hagl_color_t *ptr = (hagl_color_t *) display->buffer;
+    return ptr[display->width * y0 + x0];
+}
+
+static hagl_color_t
+color(void *self, uint8_t r, uint8_t g, uint8_t b)
+{
+    /* RGB565 in display byte order, same as the MIPI HAL. */
+    hagl_color_t rgb565 = ((r & 0xf8) << 8) | ((g & 0xfc) << 3) | (b >> 3);
+    return (rgb565 >> 8) | (rgb565 << 8);
+}
+
+static void
+blit(void *self, int16_t x0, int16_t y0, hagl_bitmap_t *src)
+{
+    hagl_backend_t *display = self;
+    hagl_color_t *dst = (hagl_color_t *) display->buffer + display->width * y0 + x0;
+    uint8_t *ptr = src->buffer;
+
+    for (int16_t y = 0; y < src->height; y++) {
+        memcpy(dst, ptr, src->width * sizeof(hagl_color_t));
+        dst += display->width;
+        ptr += src->pitch;
+    }
+}
+
+static void
+hline(void *self, int16_t x0, int16_t y0, uint16_t width, hagl_color_t color)
+{
+    hagl_backend_t *display = self;
+    hagl_color_t *ptr = (hagl_color_t *) display->buffer + display->width * y0 + x0;
+    while (width--) {
+        *(ptr++) = color;
+    }
+}
+
+static void
+vline(void *self, int16_t x0, int16_t y0, uint16_t height, hagl_color_t color)
+{
+    hagl_backend_t *display = self;
+    hagl_color_t *ptr = (hagl_color_t *) display->buffer + display->width * y0 + x0;
+    while (height--) {
+        *ptr = color;
+        ptr += display->width;
+    }
+}
+
+static size_t
+flush(void *self)
+{
+    hagl_backend_t *display = self;
+    return display->width * display->height * (display->depth / 8);
+}
+
+static void
+close(void *self)
+{
+    hagl_backend_t *display = self;
+    free(display->buffer);
+    display->buffer = NULL;
+}
+
+hagl_backend_t *
+hagl_init(void)
+{
+    memset(&backend, 0, sizeof(hagl_backend_t));
+
+    backend.width = DISPLAY_WIDTH;
+    backend.height = DISPLAY_HEIGHT;
+    backend.depth = DISPLAY_DEPTH;
+    backend.put_pixel = put_pixel;
+    backend.get_pixel = get_pixel;
+    backend.color = color;
+    backend.blit = blit;
+    backend.hline = hline;
+    backend.vline = vline;
+    backend.flush = flush;
+    backend.close = close;
+    backend.buffer = calloc(DISPLAY_WIDTH * DISPLAY_HEIGHT, sizeof(hagl_color_t));
+
+    hagl_set_clip(&backend, 0, 0, DISPLAY_WIDTH - 1, DISPLAY_HEIGHT - 1);
+
+    return &backend;
+}
+
+size_t
+hagl_flush(hagl_backend_t *display)
+{
+    return display->flush(display);
+}
+
+void
+hagl_close(hagl_backend_t *display)
+{
+    display->close(display);
+}
+
+void
+hagl_bitmap_init(hagl_bitmap_t *bitmap, int16_t width, int16_t height, uint8_t depth, void *buffer)
+{
+    bitmap->width = width;
+    bitmap->height = height;
+    bitmap->depth = depth;
+    bitmap->pitch = width * (depth / 8);
+    bitmap->size = bitmap->pitch * height;
+    bitmap->buffer = buffer;
+}
+
+hagl_color_t
+hagl_color(void const *surface, uint8_t r, uint8_t g, uint8_t b)
+{
+    hagl_backend_t *display = (hagl_backend_t *) surface;
+    return display->color(display, r, g, b);
+}
+
+void
+hagl_set_clip(void const *surface, int16_t x0, int16_t y0, int16_t x1, int16_t y1)
+{
+    hagl_backend_t *display = (hagl_backend_t *) surface;
+    display->clip.x0 = x0;
+    display->clip.y0 = y0;
+    display->clip.x1 = x1;
+    display->clip.y1 = y1;
+}
+
+void
+hagl_clear(void const *surface)
+{
+    hagl_backend_t *display = (hagl_backend_t *) surface;
+    const hagl_window_t clip = display->clip;
+
+    /* Same as HAGL, goes through the backend so wrapped buffers work. */
+    hagl_set_clip(display, 0, 0, display->width - 1, display->height - 1);
+    hagl_fill_rectangle(display, 0, 0, display->width - 1, display->height - 1, 0);
+    display->clip = clip;
+}
+
+void
+hagl_put_pixel(void const *surface, int16_t x0, int16_t y0, hagl_color_t color)
+{
+    hagl_backend_t *display = (hagl_backend_t *) surface;
+
+    /* x0 or y0 is before the edge, nothing to do. */
+    if ((x0 < display->clip.x0) || (y0 < display->clip.y0))  {
+        return;
+    }
+
+    /* x0 or y0 is after the edge, nothing to do. */
+    if ((x0 > display->clip.x1) || (y0 > display->clip.y1)) {
+        return;
+    }
+
+    display->put_pixel(display, x0, y0, color);
+}
+
+hagl_color_t
+hagl_get_pixel(void const *surface, int16_t x0, int16_t y0)
+{
+    hagl_backend_t *display = (hagl_backend_t *) surface;
+
+    if ((x0 < display->clip.x0) || (y0 < display->clip.y0))  {
+        return 0;
+    }
+
+    if ((x0 > display->clip.x1) || (y0 > display->clip.y1)) {
+        return 0;
+    }
+
+    return display->get_pixel(display, x0, y0);
+}
+
+void
+hagl_draw_hline(void const *surface, int16_t x0, int16_t y0, uint16_t w, hagl_color_t color)
+{
+    hagl_backend_t *display = (hagl_backend_t *) surface;
+    int16_t width = w;
+
+    /* x0 or y0 is over the edge, nothing to do. */
+    if ((x0 > display->clip.x1) || (y0 > display->clip.y1) || (y0 < display->clip.y0))  {
+        return;
+    }
+
+    /* x0 is left of clip window, ignore start part. */
+    if (x0 < display->clip.x0) {
+        width = width + (x0 - display->clip.x0);
+        x0 = display->clip.x0;
+    }
+
+    /* Everything is left of clip window, nothing to do. */
+    if (width <= 0)  {
+        return;
+    }
+
+    /* Cut anything going over right edge of clip window. */
+    if (((x0 + width) > display->clip.x1 + 1)) {
+        width = width - (x0 + width - 1 - display->clip.x1);
+    }
+
+    display->hline(display, x0, y0, width, color);
+}
+
+void
+hagl_fill_rectangle(void const *surface, int16_t x0, int16_t y0, int16_t x1, int16_t y1, hagl_color_t color)
+{
+    hagl_backend_t *display = (hagl_backend_t *) surface;
+
+    /* Make sure x0 is smaller than x1. */
+    if (x0 > x1) {
+        int16_t tmp = x0;
+        x0 = x1;
+        x1 = tmp;
+    }
+
+    /* Make sure y0 is smaller than y1. */
+    if (y0 > y1) {
+        int16_t tmp = y0;
+        y0 = y1;
+        y1 = tmp;
+    }
+
+    /* x1 or y1 is before the edge, nothing to do. */
+    if ((x1 < display->clip.x0) || (y1 < display->clip.y0))  {
+        return;
+    }
+
+    /* x0 or y0 is after the edge, nothing to do. */
+    if ((x0 > display->clip.x1) || (y0 > display->clip.y1)) {
+        return;
+    }
+
+    x0 = (x0 < display->clip.x0) ? display->clip.x0 : x0;
+    y0 = (y0 < display->clip.y0) ? display->clip.y0 : y0;
+    x1 = (x1 > display->clip.x1) ? display->clip.x1 : x1;
+    y1 = (y1 > display->clip.y1) ? display->clip.y1 : y1;
+
+    uint16_t width = x1 - x0 + 1;
+    uint16_t height = y1 - y0 + 1;
+
+    for (uint16_t i = 0; i < height; i++) {
+        display->hline(display, x0, y0 + i, width, color);
+    }
+}
+
+void
+hagl_blit_xy(void const *surface, int16_t x0, int16_t y0, hagl_bitmap_t *source)
+{
+    hagl_backend_t *display = (hagl_backend_t *) surface;
+
+    /* Check if bitmap is inside clip windows bounds. */
+    if (
+        (x0 < display->clip.x0) ||
+        (y0 < display->clip.y0) ||
+        (x0 + source->width - 1 > display->clip.x1) ||
+        (y0 + source->height - 1 > display->clip.y1)
+    ) {
+        /* Out of bounds, use local pixel fallback. */
+        hagl_color_t *ptr = (hagl_color_t *) source->buffer;
+        for (int16_t y = 0; y < source->height; y++) {
+            for (int16_t x = 0; x < source->width; x++) {
+                hagl_put_pixel(display, x0 + x, y0 + y, *(ptr++));
+            }
+        }
+    } else {
+        display->blit(display, x0, y0, source);
+    }
+}
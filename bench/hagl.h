@@ -0,0 +1,96 @@
+/*
+
+MIT No Attribution
+
+Copyright (c) 2023 Mika Tuupola
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+-cut-
+
+Minimal subset of the HAGL API used by the effects. The backend draws
+into an in-memory RGB565 framebuffer so that effects can be benchmarked
+on the host without a display.
+
+SPDX-License-Identifier: MIT-0
+
+*/
+
+#ifndef _HAGL_H
+#define _HAGL_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "hagl_hal.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef uint16_t hagl_color_t;
+
+typedef struct {
+    uint16_t x0;
+    uint16_t y0;
+    uint16_t x1;
+    uint16_t y1;
+} hagl_window_t;
+
+typedef struct {
+    int16_t width;
+    int16_t height;
+    uint8_t depth;
+    uint16_t pitch;
+    uint32_t size;
+    uint8_t *buffer;
+} hagl_bitmap_t;
+
+typedef struct {
+    int16_t width;
+    int16_t height;
+    uint8_t depth;
+    hagl_window_t clip;
+    void (*put_pixel)(void *self, int16_t x0, int16_t y0, hagl_color_t color);
+    hagl_color_t (*get_pixel)(void *self, int16_t x0, int16_t y0);
+    hagl_color_t (*color)(void *self, uint8_t r, uint8_t g, uint8_t b);
+    void (*blit)(void *self, int16_t x0, int16_t y0, hagl_bitmap_t *src);
+    void (*hline)(void *self, int16_t x0, int16_t y0, uint16_t width, hagl_color_t color);
+    void (*vline)(void *self, int16_t x0, int16_t y0, uint16_t height, hagl_color_t color);
+    size_t (*flush)(void *self);
+    void (*close)(void *self);
+    uint8_t *buffer;
+} hagl_backend_t;
+
+hagl_backend_t *hagl_init(void);
+size_t hagl_flush(hagl_backend_t *backend);
+void hagl_close(hagl_backend_t *backend);
+
+void hagl_bitmap_init(hagl_bitmap_t *bitmap, int16_t width, int16_t height, uint8_t depth, void *buffer);
+
+hagl_color_t hagl_color(void const *surface, uint8_t r, uint8_t g, uint8_t b);
+void hagl_set_clip(void const *surface, int16_t x0, int16_t y0, int16_t x1, int16_t y1);
+void hagl_clear(void const *surface);
+void hagl_put_pixel(void const *surface, int16_t x0, int16_t y0, hagl_color_t color);
+hagl_color_t hagl_get_pixel(void const *surface, int16_t x0, int16_t y0);
+void hagl_draw_hline(void const *surface, int16_t x0, int16_t y0, uint16_t width, hagl_color_t color);
+void hagl_fill_rectangle(void const *surface, int16_t x0, int16_t y0, int16_t x1, int16_t y1, hagl_color_t color);
+void hagl_blit_xy(void const *surface, int16_t x0, int16_t y0, hagl_bitmap_t *source);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* _HAGL_H */
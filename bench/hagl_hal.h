@@ -0,0 +1,46 @@
+/*
+
+MIT No Attribution
+
+Copyright (c) 2023 Mika Tuupola
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+-cut-
+
+In-memory stand-in for the hagl_esp_mipi HAL. Display size is given
+at compile time, one benchmark binary is built per resolution.
+
+SPDX-License-Identifier: MIT-0
+
+*/
+
+#ifndef _HAGL_HAL_H
+#define _HAGL_HAL_H
+
+#ifndef DISPLAY_WIDTH
+#define DISPLAY_WIDTH   (320)
+#endif
+
+#ifndef DISPLAY_HEIGHT
+#define DISPLAY_HEIGHT  (240)
+#endif
+
+#define DISPLAY_DEPTH   (16)
+
+#define HAGL_HAS_HAL_BACK_BUFFER
+
+#endif /* _HAGL_HAL_H */
@@ -0,0 +1,387 @@
+/*
+
+MIT No Attribution
+
+Copyright (c) 2023 Mika Tuupola
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+-cut-
+
+Single precision floating point reference versions of the effects.
+These are kept deliberately simple and must not share code with the
+kernels they validate. Parameters come from the same CONFIG_EFFECTS_*
+values as the effects so that overriding one keeps them comparable.
+
+SPDX-License-Identifier: MIT-0
+
+*/
+
+#include "sdkconfig.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <hagl.h>
+
+#include "head.h"
+#include "reference.h"
+
+static hagl_color_t **frame_buffers;
+static hagl_window_t const *frame_clip;
+
+hagl_color_t
+reference_color(uint8_t r, uint8_t g, uint8_t b)
+{
+    hagl_color_t rgb565 = ((r & 0xf8) << 8) | ((g & 0xfc) << 3) | (b >> 3);
+    return (rgb565 >> 8) | (rgb565 << 8);
+}
+
+void
+reference_rgb(hagl_color_t color, uint8_t *r, uint8_t *g, uint8_t *b)
+{
+    hagl_color_t rgb565 = (color >> 8) | (color << 8);
+    *r = (rgb565 >> 8) & 0xf8;
+    *g = (rgb565 >> 3) & 0xfc;
+    *b = (rgb565 << 3) & 0xf8;
+}
+
+/*
+ * Fill a size x size block in each of the buffers, honouring the clip
+ * window. Choices other than the first differ only where the effect may
+ * round either way.
+ */
+static void
+put_choices(int16_t x0, int16_t y0, uint8_t size, hagl_color_t const choices[REFERENCE_CHOICES])
+{
+    for (int16_t y = y0; y < y0 + size; y++) {
+        for (int16_t x = x0; x < x0 + size; x++) {
+            if (x < frame_clip->x0 || x > frame_clip->x1 || y < frame_clip->y0 || y > frame_clip->y1) {
+                continue;
+            }
+            for (uint8_t i = 0; i < REFERENCE_CHOICES; i++) {
+                frame_buffers[i][DISPLAY_WIDTH * y + x] = choices[i];
+            }
+        }
+    }
+}
+
+static void
+put_block(int16_t x0, int16_t y0, uint8_t size, hagl_color_t color)
+{
+    const hagl_color_t choices[REFERENCE_CHOICES] = { color, color, color, color };
+    put_choices(x0, y0, size, choices);
+}
+
+static hagl_color_t
+head_pixel(int16_t u, int16_t v)
+{
+    return *(hagl_color_t *) (head + HEAD_WIDTH * sizeof(hagl_color_t) * v + sizeof(hagl_color_t) * u);
+}
+
+/* Metaballs */
+
+static struct {
+    float x, y, vx, vy, radius;
+} balls[16];
+
+static const uint8_t METABALLS_NUM_BALLS = CONFIG_EFFECTS_METABALLS_BALLS;
+static const uint8_t METABALLS_PIXEL_SIZE = CONFIG_EFFECTS_METABALLS_PIXEL_SIZE;
+static const uint8_t METABALLS_MIN_RADIUS = CONFIG_EFFECTS_METABALLS_MIN_RADIUS;
+static const uint8_t METABALLS_MAX_RADIUS = CONFIG_EFFECTS_METABALLS_MAX_RADIUS;
+
+static void
+metaballs_init(uint32_t seed)
+{
+    srand(seed);
+    for (uint8_t i = 0; i < METABALLS_NUM_BALLS; i++) {
+        balls[i].radius = (rand() % METABALLS_MAX_RADIUS) + METABALLS_MIN_RADIUS;
+        balls[i].x = rand() % DISPLAY_WIDTH;
+        balls[i].y = rand() % DISPLAY_HEIGHT;
+        balls[i].vx = (rand() % 5) + 3;
+        balls[i].vy = (rand() % 5) + 3;
+    }
+}
+
+static void
+metaballs_frame(hagl_color_t *buffers[REFERENCE_CHOICES], hagl_window_t const *clip)
+{
+    const hagl_color_t black = reference_color(0, 0, 0);
+    const hagl_color_t white = reference_color(255, 255, 255);
+    const hagl_color_t green = reference_color(0, 255, 0);
+
+    frame_buffers = buffers;
+    frame_clip = clip;
+
+    for (uint8_t i = 0; i < METABALLS_NUM_BALLS; i++) {
+        balls[i].x += balls[i].vx;
+        balls[i].y += balls[i].vy;
+        if (balls[i].x < 0 || balls[i].x > DISPLAY_WIDTH) {
+            balls[i].vx = -balls[i].vx;
+        }
+        if (balls[i].y < 0 || balls[i].y > DISPLAY_HEIGHT) {
+            balls[i].vy = -balls[i].vy;
+        }
+    }
+
+    for (int16_t y = 0; y < DISPLAY_HEIGHT; y += METABALLS_PIXEL_SIZE) {
+        for (int16_t x = 0; x < DISPLAY_WIDTH; x += METABALLS_PIXEL_SIZE) {
+            float sum = 0;
+            for (uint8_t i = 0; i < METABALLS_NUM_BALLS; i++) {
+                const float dx = x - balls[i].x;
+                const float dy = y - balls[i].y;
+                sum += balls[i].radius * balls[i].radius / (dx * dx + dy * dy);
+            }
+
+            hagl_color_t color = black;
+            if (sum > 0.65) {
+                color = black;
+            } else if (sum > 0.5) {
+                color = white;
+            } else if (sum > 0.4) {
+                color = green;
+            }
+            put_block(x, y, METABALLS_PIXEL_SIZE, color);
+        }
+    }
+}
+
+/* Plasma */
+
+static const uint8_t PLASMA_SPEED = CONFIG_EFFECTS_PLASMA_SPEED;
+static const uint8_t PLASMA_PIXEL_SIZE = CONFIG_EFFECTS_PLASMA_PIXEL_SIZE;
+static uint32_t plasma_frame_count;
+
+static void
+plasma_init(uint32_t seed)
+{
+    plasma_frame_count = 0;
+}
+
+static void
+plasma_frame(hagl_color_t *buffers[REFERENCE_CHOICES], hagl_window_t const *clip)
+{
+    frame_buffers = buffers;
+    frame_clip = clip;
+
+    plasma_frame_count++;
+
+    for (int16_t y = 0; y < DISPLAY_HEIGHT; y += PLASMA_PIXEL_SIZE) {
+        for (int16_t x = 0; x < DISPLAY_WIDTH; x += PLASMA_PIXEL_SIZE) {
+            const double v1 = 128.0 + (128.0 * sin(x / 32.0));
+            const double v2 = 128.0 + (128.0 * sin(y / 24.0));
+            const double v3 = 128.0 + (128.0 * sin(sqrt(x * x + y * y) / 24.0));
+            const uint8_t index = (uint8_t) ((v1 + v2 + v3) / 3) + plasma_frame_count * PLASMA_SPEED;
+
+            const uint8_t r = 128.0 + 128.0 * sin((M_PI * index / 128.0) + 1);
+            const uint8_t g = 128.0 + 128.0 * sin((M_PI * index / 64.0) + 1);
+            put_block(x, y, PLASMA_PIXEL_SIZE, reference_color(r, g, 64));
+        }
+    }
+}
+
+/* Sine plasma */
+
+static const uint8_t SINEPLASMA_PIXEL_SIZE = CONFIG_EFFECTS_SINEPLASMA_PIXEL_SIZE;
+static uint32_t sineplasma_frame_count;
+
+static void
+sineplasma_init(uint32_t seed)
+{
+    sineplasma_frame_count = 0;
+}
+
+/* Sine of a phase given in 1/256 turns, scaled to 0 ... 85. */
+static float
+sineplasma_sine(float phase)
+{
+    return (128.0f + 127.0f * sinf(2 * M_PI * phase / 256.0f)) / 3.0f;
+}
+
+static void
+sineplasma_frame(hagl_color_t *buffers[REFERENCE_CHOICES], hagl_window_t const *clip)
+{
+    frame_buffers = buffers;
+    frame_clip = clip;
+
+    sineplasma_frame_count++;
+
+    const uint32_t n = sineplasma_frame_count;
+    const int16_t width = (DISPLAY_WIDTH + SINEPLASMA_PIXEL_SIZE - 1) / SINEPLASMA_PIXEL_SIZE;
+    const int16_t height = (DISPLAY_HEIGHT + SINEPLASMA_PIXEL_SIZE - 1) / SINEPLASMA_PIXEL_SIZE;
+
+    /* Center of the radial layer moves along a Lissajous curve. */
+    const uint8_t sx = sineplasma_sine((uint8_t) (n * 2));
+    const uint8_t sy = sineplasma_sine((uint8_t) (n * 3));
+    const int16_t cx = (width - sx * width / 86) * SINEPLASMA_PIXEL_SIZE;
+    const int16_t cy = (height - sy * height / 86) * SINEPLASMA_PIXEL_SIZE;
+
+    for (int16_t y = 0; y < DISPLAY_HEIGHT; y += SINEPLASMA_PIXEL_SIZE) {
+        for (int16_t x = 0; x < DISPLAY_WIDTH; x += SINEPLASMA_PIXEL_SIZE) {
+            const float dx = x - cx;
+            const float dy = y - cy;
+            const float v1 = sineplasma_sine(x * 5.0f / 4.0f + n * 3.0f);
+            const float v2 = sineplasma_sine(y * 7.0f / 4.0f - n * 2.0f);
+            const float v3 = sineplasma_sine(sqrtf(3.0f * (dx * dx + dy * dy)) - n * 5.0f);
+            const uint8_t index = v1 + v2 + v3;
+
+            const uint8_t r = 128.0 + 128.0 * sin((M_PI * index / 128.0) + 1);
+            const uint8_t g = 128.0 + 128.0 * sin((M_PI * index / 64.0) + 1);
+            put_block(x, y, SINEPLASMA_PIXEL_SIZE, reference_color(r, g, 64));
+        }
+    }
+}
+
+/* Rotozoom */
+
+static const uint8_t ROTOZOOM_SPEED = CONFIG_EFFECTS_ROTOZOOM_SPEED;
+static const uint8_t ROTOZOOM_PIXEL_SIZE = CONFIG_EFFECTS_ROTOZOOM_PIXEL_SIZE;
+static uint16_t rotozoom_angle;
+
+static void
+rotozoom_init(uint32_t seed)
+{
+    rotozoom_angle = 0;
+}
+
+/*
+ * At multiples of 45 degrees many coordinates are whole numbers, the
+ * effect steps in fixed point and may land on either side of them.
+ * Texels on both sides of an edge closer than this are accepted.
+ */
+static const float ROTOZOOM_EDGE = 1 / 64.0f;
+
+/* Coordinate on the other side of a nearby texel edge, if any. */
+static float
+rotozoom_across(float t)
+{
+    if ((int16_t) (t - ROTOZOOM_EDGE) != (int16_t) t) {
+        return t - ROTOZOOM_EDGE;
+    }
+    if ((int16_t) (t + ROTOZOOM_EDGE) != (int16_t) t) {
+        return t + ROTOZOOM_EDGE;
+    }
+    return t;
+}
+
+static hagl_color_t
+rotozoom_texel(float u, float v)
+{
+    int16_t tu = (int16_t) u % HEAD_WIDTH;
+    int16_t tv = (int16_t) v % HEAD_HEIGHT;
+    tu = abs(tu);
+    if (tv < 0) {
+        tv += HEAD_HEIGHT;
+    }
+    return head_pixel(tu, tv);
+}
+
+static void
+rotozoom_frame(hagl_color_t *buffers[REFERENCE_CHOICES], hagl_window_t const *clip)
+{
+    frame_buffers = buffers;
+    frame_clip = clip;
+
+    rotozoom_angle = (rotozoom_angle + ROTOZOOM_SPEED) % 360;
+
+    const float s = sin(rotozoom_angle * M_PI / 180);
+    const float c = cos(rotozoom_angle * M_PI / 180);
+    const float z = s * 1.2f;
+
+    for (int16_t y = 0; y < DISPLAY_HEIGHT; y += ROTOZOOM_PIXEL_SIZE) {
+        for (int16_t x = 0; x < DISPLAY_WIDTH; x += ROTOZOOM_PIXEL_SIZE) {
+            const float u = (x * c - y * s) * z;
+            const float v = (x * s + y * c) * z;
+            const float au = rotozoom_across(u);
+            const float av = rotozoom_across(v);
+            const hagl_color_t choices[REFERENCE_CHOICES] = {
+                rotozoom_texel(u, v),
+                rotozoom_texel(au, v),
+                rotozoom_texel(u, av),
+                rotozoom_texel(au, av),
+            };
+            put_choices(x, y, ROTOZOOM_PIXEL_SIZE, choices);
+        }
+    }
+}
+
+/* Deform */
+
+static const uint8_t DEFORM_SPEED = CONFIG_EFFECTS_DEFORM_SPEED;
+static const uint8_t DEFORM_PIXEL_SIZE = CONFIG_EFFECTS_DEFORM_PIXEL_SIZE;
+static uint32_t deform_frame_count;
+
+static void
+deform_init(uint32_t seed)
+{
+    deform_frame_count = 0;
+}
+
+static void
+deform_frame(hagl_color_t *buffers[REFERENCE_CHOICES], hagl_window_t const *clip)
+{
+    frame_buffers = buffers;
+    frame_clip = clip;
+
+    deform_frame_count += DEFORM_SPEED;
+
+    for (int16_t j = 0; j < DISPLAY_HEIGHT; j += DEFORM_PIXEL_SIZE) {
+        for (int16_t i = 0; i < DISPLAY_WIDTH; i += DEFORM_PIXEL_SIZE) {
+            const float x = -1.0f + 2.0f * i / DISPLAY_WIDTH;
+            const float y = -1.0f + 2.0f * j / DISPLAY_HEIGHT;
+            const float r = sqrtf(x * x + y * y);
+            const float a = atan2f(y, x);
+            const float u = cosf(a) / r;
+            const float v = sinf(a) / r;
+
+            int16_t tu = ((int8_t) (HEAD_WIDTH * u)) % HEAD_WIDTH;
+            int16_t tv = ((int8_t) (HEAD_HEIGHT * v)) % HEAD_HEIGHT;
+            tu = abs(tu + (int32_t) deform_frame_count) % HEAD_WIDTH;
+            tv = abs(tv + (int32_t) deform_frame_count) % HEAD_HEIGHT;
+
+            put_block(i, j, DEFORM_PIXEL_SIZE, head_pixel(tu, tv));
+        }
+    }
+}
+
+static const reference_t references[] = {
+    { "metaballs", metaballs_init, metaballs_frame, NULL, 0, 0.01f },
+    { "plasma", plasma_init, plasma_frame, NULL, 8, 0.001f },
+#ifdef CONFIG_EFFECTS_FIXED_POINT
+    /*
+     * Q15 trigonometry moves some texture coordinates across a texel edge,
+     * near the centre of deform the edges are only a few pixels apart.
+     */
+    { "rotozoom", rotozoom_init, rotozoom_frame, NULL, 0, 0.02f },
+    { "deform", deform_init, deform_frame, NULL, 0, 0.04f },
+#else
+    { "rotozoom", rotozoom_init, rotozoom_frame, NULL, 0, 0.01f },
+    { "deform", deform_init, deform_frame, NULL, 0, 0.005f },
+#endif /* CONFIG_EFFECTS_FIXED_POINT */
+    { "sineplasma", sineplasma_init, sineplasma_frame, NULL, 24, 0.002f },
+};
+
+reference_t const *
+reference_find(const char *name)
+{
+    for (uint8_t i = 0; i < sizeof(references) / sizeof(reference_t); i++) {
+        if (0 == strcmp(name, references[i].name)) {
+            return &references[i];
+        }
+    }
+    return NULL;
+}
@@ -0,0 +1,60 @@
+/*
+
+MIT No Attribution
+
+Copyright (c) 2023 Mika Tuupola
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+-cut-
+
+SPDX-License-Identifier: MIT-0
+
+*/
+
+#ifndef _REFERENCE_H
+#define _REFERENCE_H
+
+#include <stdint.h>
+#include <hagl.h>
+
+/*
+ * Frame writes this many buffers. Where the effect may round either way,
+ * such as texture coordinates on a texel edge, each holds one of the
+ * acceptable colors. Elsewhere they are all the same.
+ */
+#define REFERENCE_CHOICES   4
+
+/*
+ * Straightforward floating point implementation of an effect. Used to
+ * validate the optimized kernels in main/ frame by frame. A frame passes
+ * when at most max_error of the pixels differ by more than max_delta
+ * in any of the 8 bit color channels from all of the choices.
+ */
+typedef struct {
+    const char *name;
+    void (*init)(uint32_t seed);
+    void (*frame)(hagl_color_t *buffers[REFERENCE_CHOICES], hagl_window_t const *clip);
+    void (*close)();
+    uint8_t max_delta;
+    float max_error;
+} reference_t;
+
+reference_t const *reference_find(const char *name);
+hagl_color_t reference_color(uint8_t r, uint8_t g, uint8_t b);
+void reference_rgb(hagl_color_t color, uint8_t *r, uint8_t *g, uint8_t *b);
+
+#endif /* _REFERENCE_H */
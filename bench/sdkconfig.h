@@ -0,0 +1,81 @@
+/*
+
+MIT No Attribution
+
+Copyright (c) 2020-2023 Mika Tuupola
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+
+-cut-
+
+Stand-in for the sdkconfig.h generated by ESP-IDF. Values are the
+defaults from main/Kconfig. Any of them can be overridden from the
+command line, for example with -DCONFIG_EFFECTS_PLASMA_PIXEL_SIZE=3
+in CMAKE_C_FLAGS. Checksums in bench/reference assume the defaults.
+
+SPDX-License-Identifier: MIT-0
+
+*/
+
+#ifndef _SDKCONFIG_H
+#define _SDKCONFIG_H
+
+#ifndef CONFIG_EFFECTS_METABALLS_PIXEL_SIZE
+#define CONFIG_EFFECTS_METABALLS_PIXEL_SIZE 2
+#endif
+#ifndef CONFIG_EFFECTS_METABALLS_BALLS
+#define CONFIG_EFFECTS_METABALLS_BALLS 3
+#endif
+#ifndef CONFIG_EFFECTS_METABALLS_MIN_RADIUS
+#define CONFIG_EFFECTS_METABALLS_MIN_RADIUS 22
+#endif
+#ifndef CONFIG_EFFECTS_METABALLS_MAX_RADIUS
+#define CONFIG_EFFECTS_METABALLS_MAX_RADIUS 32
+#endif
+
+#ifndef CONFIG_EFFECTS_PLASMA_PIXEL_SIZE
+#define CONFIG_EFFECTS_PLASMA_PIXEL_SIZE 2
+#endif
+#ifndef CONFIG_EFFECTS_PLASMA_SPEED
+#define CONFIG_EFFECTS_PLASMA_SPEED 4
+#endif
+
+#ifndef CONFIG_EFFECTS_ROTOZOOM_PIXEL_SIZE
+#define CONFIG_EFFECTS_ROTOZOOM_PIXEL_SIZE 2
+#endif
+#ifndef CONFIG_EFFECTS_ROTOZOOM_SPEED
+#define CONFIG_EFFECTS_ROTOZOOM_SPEED 2
+#endif
+
+#ifndef CONFIG_EFFECTS_DEFORM_PIXEL_SIZE
+#define CONFIG_EFFECTS_DEFORM_PIXEL_SIZE 1
+#endif
+#ifndef CONFIG_EFFECTS_DEFORM_SPEED
+#define CONFIG_EFFECTS_DEFORM_SPEED 2
+#endif
+
+#ifndef CONFIG_EFFECTS_SINEPLASMA_PIXEL_SIZE
+#define CONFIG_EFFECTS_SINEPLASMA_PIXEL_SIZE 2
+#endif
+
+/*
+ * Bilinear upscaling is off unless CONFIG_EFFECTS_*_BILINEAR is defined.
+ * CONFIG_EFFECTS_INDEXED is defined only for the bench_*_indexed
+ * binaries, it reserves arena space for the palettized textures.
+ */
+
+#endif /* _SDKCONFIG_H */
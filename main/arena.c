@@ -0,0 +1,101 @@
+/*
+
+MIT No Attribution
+
+Copyright (c) 2020-2023 Mika Tuupola
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+-cut-
+
+Effects allocate their buffers from one arena which is reserved at
+boot. Current effect allocates from one end and the next effect from
+the other, so it can be initialized before the switch. Switching
+releases an end of the arena instead of freeing and allocating, so the
+heap does not get fragmented no matter how long the demo runs. Tables
+are read every frame so the arena prefers internal memory.
+
+SPDX-License-Identifier: MIT-0
+
+*/
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "arena.h"
+#include "asset.h"
+
+static uint8_t *arena;
+static size_t capacity;
+
+/* Bottom end grows up from low, top end grows down from high. */
+static size_t low;
+static size_t high;
+static bool top;
+
+bool
+arena_init(size_t size)
+{
+    arena = asset_alloc(size);
+    capacity = arena ? size : 0;
+    arena_reset();
+    return NULL != arena;
+}
+
+void *
+arena_alloc(size_t size)
+{
+    size = ARENA_SIZE(size);
+
+    if (size > high - low) {
+        return NULL;
+    }
+
+    if (top) {
+        high -= size;
+        return arena + high;
+    }
+
+    void *ptr = arena + low;
+    low += size;
+    return ptr;
+}
+
+void
+arena_flip()
+{
+    top = !top;
+    if (top) {
+        high = capacity;
+    } else {
+        low = 0;
+    }
+}
+
+void
+arena_reset()
+{
+    low = 0;
+    high = capacity;
+    top = false;
+}
+
+size_t
+arena_used()
+{
+    return low + capacity - high;
+}
@@ -0,0 +1,62 @@
+/*
+
+MIT No Attribution
+
+Copyright (c) 2020-2023 Mika Tuupola
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+-cut-
+
+SPDX-License-Identifier: MIT-0
+
+*/
+
+#ifndef _ARENA_H
+#define _ARENA_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#define ARENA_ALIGN     (8)
+
+/* Space an allocation of given size takes from the arena. */
+#define ARENA_SIZE(size) (((size) + ARENA_ALIGN - 1) & ~(size_t) (ARENA_ALIGN - 1))
+
+/*
+ * Reserve the arena once at boot with asset_alloc(). Returns false if
+ * out of memory.
+ */
+bool arena_init(size_t size);
+
+/* Bump allocate from the arena. Returns NULL when the arena is full. */
+void *arena_alloc(size_t size);
+
+/*
+ * The arena is used from both ends. Flipping makes further allocations
+ * come from the other end and releases everything previously allocated
+ * there. Lets the next effect be initialized while the current one is
+ * still running.
+ */
+void arena_flip();
+
+/* Release everything allocated from both ends. */
+void arena_reset();
+
+/* Bytes currently allocated. */
+size_t arena_used();
+
+#endif /* _ARENA_H */
@@ -0,0 +1,167 @@
+/*
+
+MIT No Attribution
+
+Copyright (c) 2020-2023 Mika Tuupola
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+
+-cut-
+
+Keeps the data the render loops read every frame out of flash. Reads
+through the flash cache stall whenever the cache misses, and textures
+stored in flash are in whatever byte order they were converted to. At
+boot the textures are copied to internal memory in the color format of
+the display with every row starting at a cache line boundary.
+
+SPDX-License-Identifier: MIT-0
+
+*/
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <hagl.h>
+
+#ifdef ESP_PLATFORM
+#include <esp_heap_caps.h>
+#include <esp_log.h>
+#include <esp_memory_utils.h>
+#endif /* ESP_PLATFORM */
+
+#include "asset.h"
+#include "indexed.h"
+#include "head.h"
+
+_Static_assert(sizeof(head) >= ASSET_HEAD_WIDTH * ASSET_HEAD_HEIGHT * sizeof(hagl_color_t), "head.h does not match asset.h");
+_Static_assert(ASSET_TILE * ASSET_TILE * sizeof(hagl_color_t) == ASSET_ALIGN, "tile is not one cache line");
+_Static_assert(0 == ASSET_HEAD_HEIGHT % ASSET_TILE, "head is not a whole number of tiles high");
+
+#ifdef ESP_PLATFORM
+static const char *TAG = "asset";
+#endif /* ESP_PLATFORM */
+
+/* Until converted the head image is read from flash as is. */
+static asset_texture_t resident_head = {
+    .colors = (hagl_color_t const *) head,
+    .stride = ASSET_HEAD_WIDTH,
+    .layout = ASSET_LINEAR,
+};
+
+void *
+asset_alloc(size_t size)
+{
+#ifdef ESP_PLATFORM
+    void *ptr = NULL;
+
+    if (heap_caps_get_free_size(MALLOC_CAP_INTERNAL) >= size + ASSET_RESERVE) {
+        ptr = heap_caps_aligned_alloc(ASSET_ALIGN, size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    }
+    if (NULL == ptr) {
+        ptr = heap_caps_aligned_alloc(ASSET_ALIGN, size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    }
+    if (NULL == ptr) {
+        /* No PSRAM, eat into the reserve instead. */
+        ptr = heap_caps_aligned_alloc(ASSET_ALIGN, size, MALLOC_CAP_8BIT);
+    }
+    if (ptr) {
+        ESP_LOGI(TAG, "%u bytes in %s memory", size, esp_ptr_external_ram(ptr) ? "external" : "internal");
+    }
+    return ptr;
+#else
+    /*
+     * Plain malloc so the bench heap accounting sees it. Assets live
+     * until reset so the pointer can be aligned up and never freed.
+     */
+    uintptr_t ptr = (uintptr_t) malloc(size + ASSET_ALIGN - 1);
+    if (!ptr) {
+        return NULL;
+    }
+    return (void *) ((ptr + ASSET_ALIGN - 1) & ~(uintptr_t) (ASSET_ALIGN - 1));
+#endif /* ESP_PLATFORM */
+}
+
+bool
+asset_init(hagl_backend_t const *display, uint8_t layout)
+{
+    /* Indexed back buffer quantizes textures from the colors of its HAL. */
+    hagl_backend_t const *hal = indexed_target(display) ? indexed_target(display) : display;
+    /* Stride is a whole number of cache lines so also of tiles. */
+    const asset_texture_t texture = {
+        .stride = ASSET_STRIDE(ASSET_HEAD_WIDTH),
+        .layout = layout,
+    };
+    const uint16_t stride = texture.stride;
+    hagl_color_t *colors = asset_alloc(stride * ASSET_HEAD_HEIGHT * sizeof(hagl_color_t));
+
+    if (NULL == colors) {
+        return false;
+    }
+
+    for (uint16_t y = 0; y < ASSET_HEAD_HEIGHT; y++) {
+        for (uint16_t x = 0; x < stride; x++) {
+            /* Padding repeats the start of the row so it adds no new colors. */
+            const uint8_t *src = head + sizeof(hagl_color_t) * (ASSET_HEAD_WIDTH * y + x % ASSET_HEAD_WIDTH);
+            /* Stored as big endian RGB565. */
+            const uint16_t rgb = src[0] << 8 | src[1];
+            colors[asset_row(&texture, y) + asset_column(&texture, x)] = hagl_color(hal, (rgb >> 8) & 0xf8, (rgb >> 3) & 0xfc, (rgb << 3) & 0xf8);
+        }
+    }
+
+    resident_head = texture;
+    resident_head.colors = colors;
+
+    return true;
+}
+
+asset_texture_t
+asset_head()
+{
+    return resident_head;
+}
+
+void
+asset_quantize(hagl_color_t *indices, hagl_color_t *palette, asset_texture_t const *texture, uint16_t height)
+{
+    const uint16_t stride = texture->stride;
+
+    for (uint16_t v = 0; v < height; v++) {
+        for (uint16_t u = 0; u < stride; u++) {
+            indices[stride * v + u] = texture->colors[asset_row(texture, v) + asset_column(texture, u)];
+        }
+    }
+
+    indexed_quantize(indices, palette, indices, stride * height);
+
+    if (ASSET_TILED != texture->layout) {
+        return;
+    }
+
+    /* Each row of tiles takes the same place in both layouts. */
+    for (uint16_t v0 = 0; v0 < height; v0 += ASSET_TILE) {
+        hagl_color_t rows[ASSET_TILE * ASSET_STRIDE(ASSET_HEAD_WIDTH)];
+
+        memcpy(rows, indices + stride * v0, ASSET_TILE * stride * sizeof(hagl_color_t));
+        for (uint16_t v = 0; v < ASSET_TILE; v++) {
+            for (uint16_t u = 0; u < stride; u++) {
+                indices[asset_row(texture, v0 + v) + asset_column(texture, u)] = rows[stride * v + u];
+            }
+        }
+    }
+}
@@ -0,0 +1,120 @@
+/*
+
+MIT No Attribution
+
+Copyright (c) 2020-2023 Mika Tuupola
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+
+-cut-
+
+SPDX-License-Identifier: MIT-0
+
+*/
+
+#ifndef _ASSET_H
+#define _ASSET_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <hagl.h>
+
+/* Texture rows and allocations start at this boundary, one cache line. */
+#define ASSET_ALIGN     (32)
+
+/* Distance in colors between the starts of two texture rows. */
+#define ASSET_STRIDE(width) \
+    ((((width) * sizeof(hagl_color_t) + ASSET_ALIGN - 1) & ~(size_t) (ASSET_ALIGN - 1)) / sizeof(hagl_color_t))
+
+/* Head image from Second Reality used by rotozoom and deform. */
+#define ASSET_HEAD_WIDTH    (82)
+#define ASSET_HEAD_HEIGHT   (64)
+
+/* Internal memory left free for task stacks and drivers. */
+#define ASSET_RESERVE   (32 * 1024)
+
+/* Tiles are ASSET_TILE x ASSET_TILE colors, one cache line each. */
+#define ASSET_TILE      (4)
+
+/* Order of the colors in a texture. */
+enum {
+    ASSET_LINEAR = 0,
+    ASSET_TILED
+};
+
+typedef struct {
+    hagl_color_t const *colors;
+    /* Colors per row, a whole number of tiles when tiled. */
+    uint16_t stride;
+    uint8_t layout;
+} asset_texture_t;
+
+/*
+ * Offset of the color at column u of a texture from the start of its
+ * row. Color at u, v is at asset_row() + asset_column() so loops can
+ * keep both in tables, whatever the layout.
+ */
+static inline uint16_t
+asset_column(asset_texture_t const *texture, uint16_t u)
+{
+    if (ASSET_TILED == texture->layout) {
+        return (u / ASSET_TILE) * ASSET_TILE * ASSET_TILE + u % ASSET_TILE;
+    }
+    return u;
+}
+
+/* Offset of the start of row v, see above. */
+static inline uint16_t
+asset_row(asset_texture_t const *texture, uint16_t v)
+{
+    if (ASSET_TILED == texture->layout) {
+        return (v / ASSET_TILE) * ASSET_TILE * texture->stride + (v % ASSET_TILE) * ASSET_TILE;
+    }
+    return v * texture->stride;
+}
+
+/*
+ * Allocate memory for data which is read every frame. Internal memory
+ * is used if ASSET_RESERVE bytes of it stay free afterwards, PSRAM
+ * otherwise. Aligned to ASSET_ALIGN. Never freed. Returns NULL if out
+ * of memory.
+ */
+void *asset_alloc(size_t size);
+
+/*
+ * Copy the textures to memory returned by asset_alloc(), converted to
+ * the color format and byte order of the HAL behind display. With
+ * ASSET_TILED layout the colors are stored tile by tile so that nearby
+ * colors share a cache line no matter which direction they are read
+ * in. Returns false if out of memory, textures are then read from
+ * flash as is.
+ */
+bool asset_init(hagl_backend_t const *display, uint8_t layout);
+
+/* Head image in the colors of the display. */
+asset_texture_t asset_head();
+
+/*
+ * Convert a texture of given height into indices to a palette with
+ * indexed_quantize(), stored in the same layout as the texture. Colors
+ * are quantized row by row so that every layout gets the same palette.
+ * Texture can be at most as wide as the head image.
+ */
+void asset_quantize(hagl_color_t *indices, hagl_color_t *palette, asset_texture_t const *texture, uint16_t height);
+
+#endif /* _ASSET_H */
@@ -0,0 +1,57 @@
+/*
+
+MIT No Attribution
+
+Copyright (c) 2020-2023 Mika Tuupola
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+-cut-
+
+Sends full width rows to the backend below the application backends.
+
+SPDX-License-Identifier: MIT-0
+
+*/
+
+#ifndef _BLIT_H
+#define _BLIT_H
+
+#include <stdint.h>
+#include <hagl.h>
+
+/*
+ * Send the bitmap as rows starting at y0. Backends without a blit get
+ * the rows pixel by pixel. Not through hagl_blit_xy() since it clips
+ * and the HUD rows are outside the clip window.
+ */
+static inline void
+blit_rows(hagl_backend_t const *target, int16_t y0, hagl_bitmap_t *bitmap)
+{
+    if (target->blit) {
+        target->blit((void *) target, 0, y0, bitmap);
+        return;
+    }
+
+    hagl_color_t *ptr = (hagl_color_t *) bitmap->buffer;
+    for (int16_t y = y0; y < y0 + bitmap->height; y++) {
+        for (int16_t x = 0; x < bitmap->width; x++) {
+            target->put_pixel((void *) target, x, y, *(ptr++));
+        }
+    }
+}
+
+#endif /* _BLIT_H */
@@ -0,0 +1,280 @@
+/*
+
+MIT No Attribution
+
+Copyright (c) 2020-2023 Mika Tuupola
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+-cut-
+
+Persistent cache for generated lookup tables. Entries are appended to
+the backing store and read back through a memory mapped view. Each
+entry starts at a sector boundary with a header which is written last,
+so a write interrupted by reset is simply not found. When the store
+is full writing starts again from the beginning, overwriting the
+oldest entries.
+
+SPDX-License-Identifier: MIT-0
+
+*/
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifdef ESP_PLATFORM
+#include <esp_partition.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif /* ESP_PLATFORM */
+
+#include "cache.h"
+
+#define CACHE_MAGIC     (0x4c555443)
+#define CACHE_SECTOR    (4096)
+#define CACHE_HOST_SIZE (1024 * 1024)
+
+typedef struct {
+    uint32_t magic;
+    char name[16];
+    uint16_t width;
+    uint16_t height;
+    uint8_t pixel_size;
+    uint8_t reserved[3];
+    uint32_t version;
+    uint32_t size;
+    uint32_t checksum;
+} entry_t;
+
+static const uint8_t *view = NULL;
+static size_t capacity = 0;
+static size_t tail = 0;
+
+#ifdef ESP_PLATFORM
+
+static const esp_partition_t *partition;
+static esp_partition_mmap_handle_t handle;
+
+static bool
+storage_open(const char *name)
+{
+    partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, name);
+    if (NULL == partition) {
+        return false;
+    }
+    capacity = partition->size;
+    return ESP_OK == esp_partition_mmap(
+        partition, 0, capacity, ESP_PARTITION_MMAP_DATA, (const void **) &view, &handle
+    );
+}
+
+static bool
+storage_erase(size_t offset, size_t size)
+{
+    return ESP_OK == esp_partition_erase_range(partition, offset, size);
+}
+
+static bool
+storage_write(size_t offset, void const *data, size_t size)
+{
+    return ESP_OK == esp_partition_write(partition, offset, data, size);
+}
+
+/* Map again so that the view does not show stale cached flash. */
+static void
+storage_sync()
+{
+    esp_partition_munmap(handle);
+    if (ESP_OK != esp_partition_mmap(
+        partition, 0, capacity, ESP_PARTITION_MMAP_DATA, (const void **) &view, &handle
+    )) {
+        view = NULL;
+    }
+}
+
+#else
+
+static int fd = -1;
+
+static bool
+storage_open(const char *name)
+{
+    fd = open(name, O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        return false;
+    }
+    /* New file reads as zeroes, which is never a valid header. */
+    if (ftruncate(fd, CACHE_HOST_SIZE) < 0) {
+        return false;
+    }
+    capacity = CACHE_HOST_SIZE;
+    view = mmap(NULL, capacity, PROT_READ, MAP_SHARED, fd, 0);
+    if (MAP_FAILED == view) {
+        view = NULL;
+        return false;
+    }
+    return true;
+}
+
+static bool
+storage_erase(size_t offset, size_t size)
+{
+    static const uint8_t erased[CACHE_SECTOR];
+
+    for (size_t i = 0; i < size; i += CACHE_SECTOR) {
+        if (pwrite(fd, erased, CACHE_SECTOR, offset + i) != CACHE_SECTOR) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool
+storage_write(size_t offset, void const *data, size_t size)
+{
+    return pwrite(fd, data, size, offset) == (ssize_t) size;
+}
+
+/* Shared mapping already sees the writes. */
+static void
+storage_sync()
+{
+}
+
+#endif /* ESP_PLATFORM */
+
+/* FNV-1a, catches tables which were only partially written. */
+static uint32_t
+checksum(const uint8_t *data, size_t size)
+{
+    uint32_t hash = 2166136261;
+
+    while (size--) {
+        hash ^= *(data++);
+        hash *= 16777619;
+    }
+    return hash;
+}
+
+/* Space an entry takes, rounded up to whole sectors. */
+static size_t
+footprint(size_t size)
+{
+    return (sizeof(entry_t) + size + CACHE_SECTOR - 1) & ~(size_t) (CACHE_SECTOR - 1);
+}
+
+static void
+header(entry_t *entry, cache_key_t const *key, size_t size)
+{
+    memset(entry, 0, sizeof(entry_t));
+    entry->magic = CACHE_MAGIC;
+    strncpy(entry->name, key->name, sizeof(entry->name) - 1);
+    entry->width = DISPLAY_WIDTH;
+    entry->height = DISPLAY_HEIGHT;
+    entry->pixel_size = key->pixel_size;
+    entry->version = key->version;
+    entry->size = size;
+}
+
+bool
+cache_init(const char *name)
+{
+    if (!storage_open(name)) {
+        view = NULL;
+        return false;
+    }
+
+    /* Find the end of the valid entries, tail never passes capacity. */
+    tail = 0;
+    while (tail + sizeof(entry_t) <= capacity) {
+        entry_t const *entry = (entry_t const *) (view + tail);
+        if (CACHE_MAGIC != entry->magic || entry->size > capacity) {
+            break;
+        }
+        if (tail + footprint(entry->size) > capacity) {
+            break;
+        }
+        tail += footprint(entry->size);
+    }
+
+    return true;
+}
+
+bool
+cache_load(cache_key_t const *key, void *buffer, size_t size)
+{
+    entry_t wanted;
+    size_t offset = 0;
+
+    if (NULL == view) {
+        return false;
+    }
+
+    header(&wanted, key, size);
+
+    while (offset < tail) {
+        entry_t const *entry = (entry_t const *) (view + offset);
+        const uint8_t *data = view + offset + sizeof(entry_t);
+
+        /* Everything but the checksum must match. */
+        if (0 == memcmp(entry, &wanted, offsetof(entry_t, checksum))) {
+            if (entry->checksum == checksum(data, size)) {
+                memcpy(buffer, data, size);
+                return true;
+            }
+        }
+        offset += footprint(entry->size);
+    }
+
+    return false;
+}
+
+bool
+cache_store(cache_key_t const *key, void const *buffer, size_t size)
+{
+    entry_t entry;
+
+    if (NULL == view || footprint(size) > capacity) {
+        return false;
+    }
+
+    /* Full, overwrite the oldest entries. */
+    if (tail + footprint(size) > capacity) {
+        tail = 0;
+    }
+
+    header(&entry, key, size);
+    entry.checksum = checksum(buffer, size);
+
+    /* Data first, header last. */
+    if (
+        !storage_erase(tail, footprint(size)) ||
+        !storage_write(tail + sizeof(entry_t), buffer, size) ||
+        !storage_write(tail, &entry, sizeof(entry_t))
+    ) {
+        storage_sync();
+        return false;
+    }
+
+    storage_sync();
+    tail += footprint(size);
+
+    return NULL != view;
+}
@@ -0,0 +1,59 @@
+/*
+
+MIT No Attribution
+
+Copyright (c) 2020-2023 Mika Tuupola
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+-cut-
+
+SPDX-License-Identifier: MIT-0
+
+*/
+
+#ifndef _CACHE_H
+#define _CACHE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Identifies a generated table. Display size is added by the cache.
+ * Bump version whenever the generator changes so that stale tables
+ * are not used.
+ */
+typedef struct {
+    const char *name;
+    uint8_t pixel_size;
+    uint32_t version;
+} cache_key_t;
+
+/*
+ * Open the backing store. On ESP32 name is the label of a data
+ * partition, on the host it is a path to a file. Without a backing
+ * store loads always miss and stores are ignored.
+ */
+bool cache_init(const char *name);
+
+/* Copy a cached table to buffer. Returns false on a miss. */
+bool cache_load(cache_key_t const *key, void *buffer, size_t size);
+
+/* Store a freshly generated table. Returns false if it did not fit. */
+bool cache_store(cache_key_t const *key, void const *buffer, size_t size);
+
+#endif /* _CACHE_H */
@@ -28,29 +28,114 @@ SPDX-License-Identifier: MIT-0
 
 */
 
+#include "sdkconfig.h"
+
 #include <stdint.h>
 #include <stdlib.h>
 #include <math.h>
 #include <hagl.h>
 
-#include "head.h"
 #include "deform.h"
-
-static const uint8_t SPEED = 2;
-static const uint8_t PIXEL_SIZE = 1;
+#include "span.h"
+#include "arena.h"
+#include "cache.h"
+#include "indexed.h"
+#include "fixed.h"
+#include "asset.h"
+
+static const uint8_t SPEED = CONFIG_EFFECTS_DEFORM_SPEED;
+static const uint8_t PIXEL_SIZE = CONFIG_EFFECTS_DEFORM_PIXEL_SIZE;
+#ifdef CONFIG_EFFECTS_DEFORM_BILINEAR
+static const uint8_t FILTER = SPAN_BILINEAR;
+#else
+static const uint8_t FILTER = SPAN_NEAREST;
+#endif
+
+/* Bump when the generated lut changes. */
+static const uint32_t VERSION = 1 + FIXED_VERSION;
 static uint32_t frame;
 
 int8_t *lut;
 
+/* Head image, or indices to its palette with an indexed back buffer. */
+static const hagl_color_t *texture;
+static hagl_color_t *palette;
+
+/* Texture offsets of each column and row in the layout of the texture. */
+static uint16_t columns[ASSET_HEAD_WIDTH];
+static uint16_t rows[ASSET_HEAD_HEIGHT];
+
+/* Pair of texture offsets per PIXEL_SIZE x PIXEL_SIZE block. */
+#define LUT_SIZE (SPAN_WIDTH(PIXEL_SIZE) * ((DISPLAY_HEIGHT + PIXEL_SIZE - 1) / PIXEL_SIZE) * 2)
+
+size_t
+deform_arena_size()
+{
+    size_t size = ARENA_SIZE(LUT_SIZE * sizeof(int8_t));
+#ifdef CONFIG_EFFECTS_INDEXED
+    size += ARENA_SIZE(ASSET_STRIDE(ASSET_HEAD_WIDTH) * ASSET_HEAD_HEIGHT * sizeof(hagl_color_t)) + ARENA_SIZE(256 * sizeof(hagl_color_t));
+#endif /* CONFIG_EFFECTS_INDEXED */
+    return size;
+}
+
+#ifdef CONFIG_EFFECTS_FIXED_POINT
+/* Integer part of a Q33 value, towards zero like the float cast. */
+static inline int32_t
+whole(int64_t value)
+{
+    return value < 0 ? -(-value >> 33) : value >> 33;
+}
+#endif /* CONFIG_EFFECTS_FIXED_POINT */
+
 void
-deform_init()
+deform_init(hagl_backend_t const *display)
 {
+    const cache_key_t key = { "deform", PIXEL_SIZE, VERSION };
+
     /* Allocate memory for lut and store address also to ptr. */
-    int8_t *ptr = lut = malloc(DISPLAY_HEIGHT * DISPLAY_WIDTH * 2 * sizeof(int8_t));
+    int8_t *ptr = lut = arena_alloc(LUT_SIZE * sizeof(int8_t));
+
+    const asset_texture_t head = asset_head();
+
+    texture = head.colors;
+
+    for (uint16_t u = 0; u < ASSET_HEAD_WIDTH; u++) {
+        columns[u] = asset_column(&head, u);
+    }
+    for (uint16_t v = 0; v < ASSET_HEAD_HEIGHT; v++) {
+        rows[v] = asset_row(&head, v);
+    }
+
+    if (indexed_target(display)) {
+        hagl_color_t *indices = arena_alloc(head.stride * ASSET_HEAD_HEIGHT * sizeof(hagl_color_t));
+        palette = arena_alloc(256 * sizeof(hagl_color_t));
+        asset_quantize(indices, palette, &head, ASSET_HEAD_HEIGHT);
+        texture = indices;
+    }
+
+    /* Skip the trigonometry when lut was generated on earlier boot. */
+    if (cache_load(&key, lut, LUT_SIZE * sizeof(int8_t))) {
+        return;
+    }
 
     for (uint16_t j = 0; j < DISPLAY_HEIGHT; j += PIXEL_SIZE) {
         for (uint16_t i = 0; i < DISPLAY_WIDTH; i += PIXEL_SIZE) {
+#ifdef CONFIG_EFFECTS_FIXED_POINT
+            /* Coordinates and radius in Q14, 1 / r in Q18. */
+            const int32_t x = -(1 << 14) + (i << 15) / DISPLAY_WIDTH;
+            const int32_t y = -(1 << 14) + (j << 15) / DISPLAY_HEIGHT;
+            const uint32_t r = fixed_isqrt(x * x + y * y);
+            const uint16_t a = fixed_atan2(y, x);
+            const uint32_t inverse = fixed_reciprocal(r);
+
+            /* Q15 times Q18 is Q33. */
+            const int64_t u = (int64_t) fixed_cos(a) * inverse;
+            const int64_t v = (int64_t) fixed_sin(a) * inverse;
 
+            /* Target x and y coordinates in the texture. */
+            const int8_t tx = ((int8_t) whole(ASSET_HEAD_WIDTH * u)) % ASSET_HEAD_WIDTH;
+            const int8_t ty = ((int8_t) whole(ASSET_HEAD_HEIGHT * v)) % ASSET_HEAD_HEIGHT;
+#else
             const float x = -1.00f + 2.00f * i / DISPLAY_WIDTH;
             const float y = -1.00f + 2.00f * j / DISPLAY_HEIGHT;
             const float r = sqrtf(x * x + y * y);
@@ -88,50 +173,56 @@ deform_init()
             // const float v = y;
 
             /* Target x and y coordinates in the texture. */
-            const int8_t tx = ((int8_t)(HEAD_WIDTH * u)) % HEAD_WIDTH;
-            const int8_t ty = ((int8_t)(HEAD_HEIGHT * v)) % HEAD_HEIGHT;
+            const int8_t tx = ((int8_t)(ASSET_HEAD_WIDTH * u)) % ASSET_HEAD_WIDTH;
+            const int8_t ty = ((int8_t)(ASSET_HEAD_HEIGHT * v)) % ASSET_HEAD_HEIGHT;
+#endif /* CONFIG_EFFECTS_FIXED_POINT */
 
             *(ptr++) = tx;
             *(ptr++) = ty;
         }
     }
+
+    cache_store(&key, lut, LUT_SIZE * sizeof(int8_t));
 }
 
-void
-deform_render(hagl_backend_t const *display)
+static void
+deform_row(hagl_color_t *colors, uint16_t row)
 {
-    int8_t *ptr = lut;
-
-    for (uint16_t y = 0; y < DISPLAY_HEIGHT; y += PIXEL_SIZE) {
-        for (uint16_t x = 0; x < DISPLAY_WIDTH; x += PIXEL_SIZE) {
+    const int8_t *ptr = lut + row * SPAN_WIDTH(PIXEL_SIZE) * 2;
+    hagl_color_t *dst = colors;
 
-            /* Retrieve texture x and y coordinates for display coordinates. */
-            int16_t u = *(ptr++) + frame;
-            int16_t v = *(ptr++) + frame;
+    for (uint16_t x = 0; x < DISPLAY_WIDTH; x += PIXEL_SIZE) {
 
-            u = abs(u) % HEAD_WIDTH;
-            v = abs(v) % HEAD_HEIGHT;
+        /* Retrieve texture x and y coordinates for display coordinates. */
+        int16_t u = *(ptr++) + frame;
+        int16_t v = *(ptr++) + frame;
 
-            /* Get the pixel from texture and put it to the screen. */
-            const hagl_color_t *color = (hagl_color_t *) (head + HEAD_WIDTH * sizeof(hagl_color_t) * v + sizeof(hagl_color_t) * u);
+        u = abs(u) % ASSET_HEAD_WIDTH;
+        v = abs(v) % ASSET_HEAD_HEIGHT;
 
-            if (1 == PIXEL_SIZE) {
-                hagl_put_pixel(display, x, y, *color);
-            } else {
-                hagl_fill_rectangle(display, x, y, x + PIXEL_SIZE - 1, y + PIXEL_SIZE - 1, *color);
-            }
-        }
+        /* Get the pixel from texture and put it to the row. */
+        *(dst++) = texture[rows[v] + columns[u]];
     }
 }
 
 void
-deform_animate()
+deform_render_rows(hagl_backend_t const *display, int16_t y0, int16_t y1)
 {
-    frame = frame + SPEED;
+    span_render(display, y0, y1, deform_row, PIXEL_SIZE, FILTER);
 }
 
 void
-deform_close()
+deform_render(hagl_backend_t const *display)
 {
-    free(lut);
+    deform_render_rows(display, SPAN_TOP(display), display->clip.y1 + 1);
+}
+
+void
+deform_animate()
+{
+    frame = frame + SPEED;
+
+    if (texture != asset_head().colors) {
+        indexed_palette(palette, 0);
+    }
 }
@@ -27,5 +27,6 @@ SPDX-License-Identifier: MIT-0
 
 void deform_init();
 void deform_render(hagl_backend_t const *surface);
+void deform_render_rows(hagl_backend_t const *surface, int16_t y0, int16_t y1);
 void deform_animate();
-void deform_close();
+size_t deform_arena_size();
@@ -0,0 +1,195 @@
+/*
+
+MIT No Attribution
+
+Copyright (c) 2020-2023 Mika Tuupola
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+-cut-
+
+Back buffer with per row dirty tracking. Every write is compared
+against what is already in the buffer and only rows whose content
+actually changed are marked. Effects which redraw the whole screen
+every frame but leave large areas untouched, such as the metaballs
+background, then send only the changed rows over SPI.
+
+SPDX-License-Identifier: MIT-0
+
+*/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <hagl.h>
+
+#include "dirty.h"
+#include "blit.h"
+
+static hagl_backend_t backend;
+static hagl_backend_t *target;
+static bool dirty[DISPLAY_HEIGHT];
+
+static void
+put_pixel(void *self, int16_t x0, int16_t y0, hagl_color_t color)
+{
+    hagl_color_t *ptr = (hagl_color_t *) backend.buffer + DISPLAY_WIDTH * y0 + x0;
+
+    if (*ptr != color) {
+        *ptr = color;
+        dirty[y0] = true;
+    }
+}
+
+static hagl_color_t
+get_pixel(void *self, int16_t x0, int16_t y0)
+{
+    hagl_color_t *ptr = (hagl_color_t *) backend.buffer;
+    return ptr[DISPLAY_WIDTH * y0 + x0];
+}
+
+static hagl_color_t
+color(void *self, uint8_t r, uint8_t g, uint8_t b)
+{
+    return hagl_color(target, r, g, b);
+}
+
+static void
+blit(void *self, int16_t x0, int16_t y0, hagl_bitmap_t *src)
+{
+    hagl_color_t *dst = (hagl_color_t *) backend.buffer + DISPLAY_WIDTH * y0 + x0;
+    const size_t size = src->width * sizeof(hagl_color_t);
+    uint8_t *ptr = src->buffer;
+
+    for (int16_t y = y0; y < y0 + src->height; y++) {
+        /* Compare first, most rows of a frame are written only once. */
+        if (!dirty[y] && 0 == memcmp(dst, ptr, size)) {
+            dst += DISPLAY_WIDTH;
+            ptr += src->pitch;
+            continue;
+        }
+        memcpy(dst, ptr, size);
+        dirty[y] = true;
+        dst += DISPLAY_WIDTH;
+        ptr += src->pitch;
+    }
+}
+
+static void
+hline(void *self, int16_t x0, int16_t y0, uint16_t width, hagl_color_t color)
+{
+    hagl_color_t *ptr = (hagl_color_t *) backend.buffer + DISPLAY_WIDTH * y0 + x0;
+
+    while (width--) {
+        if (*ptr != color) {
+            *ptr = color;
+            dirty[y0] = true;
+        }
+        ptr++;
+    }
+}
+
+static void
+vline(void *self, int16_t x0, int16_t y0, uint16_t height, hagl_color_t color)
+{
+    for (int16_t y = y0; y < y0 + height; y++) {
+        put_pixel(self, x0, y, color);
+    }
+}
+
+/* Send rows y0 ... y1 - 1 as one window. */
+static size_t
+send(int16_t y0, int16_t y1)
+{
+    hagl_bitmap_t bitmap;
+    uint8_t *buffer = backend.buffer + DISPLAY_WIDTH * y0 * sizeof(hagl_color_t);
+
+    /* Full width rows are contiguous in memory, one DMA transfer. */
+    hagl_bitmap_init(&bitmap, DISPLAY_WIDTH, y1 - y0, DISPLAY_DEPTH, buffer);
+    blit_rows(target, y0, &bitmap);
+
+    memset(&dirty[y0], 0, y1 - y0);
+    return bitmap.size;
+}
+
+static size_t
+flush(void *self)
+{
+    size_t bytes = 0;
+    int16_t y = 0;
+
+    while (y < DISPLAY_HEIGHT) {
+        if (!dirty[y]) {
+            y++;
+            continue;
+        }
+
+        /* Extend the window over short clean gaps. */
+        int16_t y1 = y + 1;
+        int16_t last = y;
+        while (y1 < DISPLAY_HEIGHT && y1 - last <= DIRTY_MERGE_GAP) {
+            if (dirty[y1]) {
+                last = y1;
+            }
+            y1++;
+        }
+
+        bytes += send(y, last + 1);
+        y = last + 1;
+    }
+
+    return bytes;
+}
+
+static void
+close(void *self)
+{
+    free(backend.buffer);
+    backend.buffer = NULL;
+    hagl_close(target);
+}
+
+hagl_backend_t *
+dirty_init(hagl_backend_t *hal)
+{
+    memset(&backend, 0, sizeof(hagl_backend_t));
+
+    backend.buffer = calloc(DISPLAY_WIDTH * DISPLAY_HEIGHT, sizeof(hagl_color_t));
+    if (NULL == backend.buffer) {
+        return NULL;
+    }
+
+    target = hal;
+
+    backend.width = DISPLAY_WIDTH;
+    backend.height = DISPLAY_HEIGHT;
+    backend.depth = DISPLAY_DEPTH;
+    backend.put_pixel = put_pixel;
+    backend.get_pixel = get_pixel;
+    backend.color = color;
+    backend.blit = blit;
+    backend.hline = hline;
+    backend.vline = vline;
+    backend.flush = flush;
+    backend.close = close;
+    backend.clip = hal->clip;
+
+    /* First flush sends everything. */
+    memset(dirty, 1, sizeof(dirty));
+
+    return &backend;
+}
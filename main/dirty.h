@@ -0,0 +1,48 @@
+/*
+
+MIT No Attribution
+
+Copyright (c) 2020-2023 Mika Tuupola
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+-cut-
+
+SPDX-License-Identifier: MIT-0
+
+*/
+
+#ifndef _DIRTY_H
+#define _DIRTY_H
+
+#include <hagl.h>
+
+/*
+ * Clean rows between two changed ones are sent anyway when the gap is
+ * at most this many rows. Saves the per transfer overhead.
+ */
+#define DIRTY_MERGE_GAP (4)
+
+/*
+ * Wrap a HAL which has no back buffer. Returns a backend with its own
+ * back buffer which remembers which rows changed since the last flush.
+ * Flushing sends only the changed rows to the HAL and returns the
+ * number of bytes sent. Returns NULL if the back buffer could not be
+ * allocated.
+ */
+hagl_backend_t *dirty_init(hagl_backend_t *hal);
+
+#endif /* _DIRTY_H */
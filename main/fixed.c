@@ -0,0 +1,252 @@
+/*
+
+MIT No Attribution
+
+Copyright (c) 2020-2023 Mika Tuupola
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+-cut-
+
+Integer only math for targets without FPU such as the ESP32-S2. Used
+when generating tables and per frame where the floating point versions
+would otherwise go through software float. Tables are const so they stay
+in flash.
+
+SPDX-License-Identifier: MIT-0
+
+*/
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "fixed.h"
+
+/* round(32768 * sin(i * pi / 512)), first quarter of the wave. */
+static const uint16_t SINE[257] = {
+    0, 201, 402, 603, 804, 1005, 1206, 1407, 1608, 1809, 2009, 2210,
+    2411, 2611, 2811, 3012, 3212, 3412, 3612, 3812, 4011, 4211, 4410, 4609,
+    4808, 5007, 5205, 5404, 5602, 5800, 5998, 6195, 6393, 6590, 6787, 6983,
+    7180, 7376, 7571, 7767, 7962, 8157, 8351, 8546, 8740, 8933, 9127, 9319,
+    9512, 9704, 9896, 10088, 10279, 10469, 10660, 10850, 11039, 11228, 11417, 11605,
+    11793, 11980, 12167, 12354, 12540, 12725, 12910, 13095, 13279, 13463, 13646, 13828,
+    14010, 14192, 14373, 14553, 14733, 14912, 15091, 15269, 15447, 15624, 15800, 15976,
+    16151, 16326, 16500, 16673, 16846, 17018, 17190, 17361, 17531, 17700, 17869, 18037,
+    18205, 18372, 18538, 18703, 18868, 19032, 19195, 19358, 19520, 19681, 19841, 20001,
+    20160, 20318, 20475, 20632, 20788, 20943, 21097, 21251, 21403, 21555, 21706, 21856,
+    22006, 22154, 22302, 22449, 22595, 22740, 22884, 23028, 23170, 23312, 23453, 23593,
+    23732, 23870, 24008, 24144, 24279, 24414, 24548, 24680, 24812, 24943, 25073, 25202,
+    25330, 25457, 25583, 25708, 25833, 25956, 26078, 26199, 26320, 26439, 26557, 26674,
+    26791, 26906, 27020, 27133, 27246, 27357, 27467, 27576, 27684, 27791, 27897, 28002,
+    28106, 28209, 28311, 28411, 28511, 28610, 28707, 28803, 28899, 28993, 29086, 29178,
+    29269, 29359, 29448, 29535, 29622, 29707, 29792, 29875, 29957, 30038, 30118, 30196,
+    30274, 30350, 30425, 30499, 30572, 30644, 30715, 30784, 30853, 30920, 30986, 31050,
+    31114, 31177, 31238, 31298, 31357, 31415, 31471, 31527, 31581, 31634, 31686, 31737,
+    31786, 31834, 31881, 31927, 31972, 32015, 32058, 32099, 32138, 32177, 32214, 32251,
+    32286, 32319, 32352, 32383, 32413, 32442, 32470, 32496, 32522, 32546, 32568, 32590,
+    32610, 32629, 32647, 32664, 32679, 32693, 32706, 32718, 32729, 32738, 32746, 32753,
+    32758, 32762, 32766, 32767, 32768,
+};
+
+/* round(atan(i / 256) * 65536 / (2 * pi)), first octant. */
+static const uint16_t ATAN[257] = {
+    0, 41, 81, 122, 163, 204, 244, 285, 326, 367, 407, 448,
+    489, 529, 570, 610, 651, 692, 732, 773, 813, 854, 894, 935,
+    975, 1015, 1056, 1096, 1136, 1177, 1217, 1257, 1297, 1337, 1377, 1417,
+    1457, 1497, 1537, 1577, 1617, 1656, 1696, 1736, 1775, 1815, 1854, 1894,
+    1933, 1973, 2012, 2051, 2090, 2129, 2168, 2207, 2246, 2285, 2324, 2363,
+    2401, 2440, 2478, 2517, 2555, 2594, 2632, 2670, 2708, 2746, 2784, 2822,
+    2860, 2897, 2935, 2973, 3010, 3047, 3085, 3122, 3159, 3196, 3233, 3270,
+    3307, 3344, 3380, 3417, 3453, 3490, 3526, 3562, 3599, 3635, 3670, 3706,
+    3742, 3778, 3813, 3849, 3884, 3920, 3955, 3990, 4025, 4060, 4095, 4129,
+    4164, 4199, 4233, 4267, 4302, 4336, 4370, 4404, 4438, 4471, 4505, 4539,
+    4572, 4605, 4639, 4672, 4705, 4738, 4771, 4803, 4836, 4869, 4901, 4933,
+    4966, 4998, 5030, 5062, 5094, 5125, 5157, 5188, 5220, 5251, 5282, 5313,
+    5344, 5375, 5406, 5437, 5467, 5498, 5528, 5559, 5589, 5619, 5649, 5679,
+    5708, 5738, 5768, 5797, 5826, 5856, 5885, 5914, 5943, 5972, 6000, 6029,
+    6058, 6086, 6114, 6142, 6171, 6199, 6227, 6254, 6282, 6310, 6337, 6365,
+    6392, 6419, 6446, 6473, 6500, 6527, 6554, 6580, 6607, 6633, 6660, 6686,
+    6712, 6738, 6764, 6790, 6815, 6841, 6867, 6892, 6917, 6943, 6968, 6993,
+    7018, 7043, 7068, 7092, 7117, 7141, 7166, 7190, 7214, 7238, 7262, 7286,
+    7310, 7334, 7358, 7381, 7405, 7428, 7451, 7475, 7498, 7521, 7544, 7566,
+    7589, 7612, 7635, 7657, 7679, 7702, 7724, 7746, 7768, 7790, 7812, 7834,
+    7856, 7877, 7899, 7920, 7942, 7963, 7984, 8005, 8026, 8047, 8068, 8089,
+    8110, 8131, 8151, 8172, 8192,
+};
+
+/* round(2^31 / (1 + i / 256)), mantissas 1.0 ... 2.0. */
+static const uint32_t RECIPROCAL[257] = {
+    2147483648, 2139127680, 2130836488, 2122609320, 2114445438, 2106344115,
+    2098304633, 2090326289, 2082408386, 2074550241, 2066751180, 2059010539,
+    2051327664, 2043701910, 2036132644, 2028619239, 2021161080, 2013757560,
+    2006408080, 1999112051, 1991868891, 1984678028, 1977538899, 1970450946,
+    1963413621, 1956426384, 1949488702, 1942600049, 1935759908, 1928967768,
+    1922223125, 1915525484, 1908874354, 1902269252, 1895709703, 1889195237,
+    1882725390, 1876299706, 1869917734, 1863579030, 1857283155, 1851029676,
+    1844818167, 1838648207, 1832519380, 1826431275, 1820383490, 1814375623,
+    1808407283, 1802478078, 1796587627, 1790735550, 1784921474, 1779145029,
+    1773405851, 1767703582, 1762037865, 1756408351, 1750814694, 1745256552,
+    1739733588, 1734245470, 1728791868, 1723372457, 1717986918, 1712634934,
+    1707316192, 1702030384, 1696777203, 1691556350, 1686367527, 1681210440,
+    1676084798, 1670990316, 1665926709, 1660893698, 1655891006, 1650918360,
+    1645975491, 1641062131, 1636178018, 1631322890, 1626496491, 1621698566,
+    1616928864, 1612187138, 1607473140, 1602786629, 1598127366, 1593495113,
+    1588889636, 1584310703, 1579758086, 1575231558, 1570730897, 1566255880,
+    1561806289, 1557381909, 1552982525, 1548607926, 1544257904, 1539932252,
+    1535630765, 1531353242, 1527099483, 1522869291, 1518662469, 1514478826,
+    1510318170, 1506180312, 1502065065, 1497972245, 1493901668, 1489853154,
+    1485826524, 1481821601, 1477838209, 1473876177, 1469935331, 1466015504,
+    1462116526, 1458238233, 1454380460, 1450543045, 1446725826, 1442928645,
+    1439151345, 1435393770, 1431655765, 1427937179, 1424237860, 1420557659,
+    1416896428, 1413254020, 1409630292, 1406025099, 1402438301, 1398869755,
+    1395319325, 1391786871, 1388272257, 1384775350, 1381296015, 1377834120,
+    1374389535, 1370962129, 1367551776, 1364158347, 1360781718, 1357421763,
+    1354078359, 1350751385, 1347440720, 1344146244, 1340867839, 1337605387,
+    1334358772, 1331127879, 1327912594, 1324712805, 1321528399, 1318359266,
+    1315205296, 1312066382, 1308942414, 1305833287, 1302738895, 1299659134,
+    1296593901, 1293543092, 1290506605, 1287484342, 1284476201, 1281482084,
+    1278501893, 1275535531, 1272582903, 1269643912, 1266718465, 1263806469,
+    1260907830, 1258022457, 1255150260, 1252291148, 1249445032, 1246611823,
+    1243791434, 1240983779, 1238188770, 1235406323, 1232636354, 1229878778,
+    1227133513, 1224400476, 1221679586, 1218970763, 1216273925, 1213588993,
+    1210915890, 1208254536, 1205604855, 1202966770, 1200340205, 1197725085,
+    1195121335, 1192528880, 1189947649, 1187377568, 1184818564, 1182270568,
+    1179733506, 1177207310, 1174691910, 1172187236, 1169693221, 1167209796,
+    1164736894, 1162274448, 1159822392, 1157380661, 1154949189, 1152527912,
+    1150116765, 1147715687, 1145324612, 1142943480, 1140572228, 1138210795,
+    1135859120, 1133517142, 1131184802, 1128862041, 1126548799, 1124245018,
+    1121950641, 1119665609, 1117389866, 1115123355, 1112866020, 1110617806,
+    1108378657, 1106148519, 1103927337, 1101715058, 1099511628, 1097316994,
+    1095131103, 1092953904, 1090785345, 1088625374, 1086473940, 1084330994,
+    1082196484, 1080070361, 1077952576, 1075843080, 1073741824,
+};
+
+int32_t
+fixed_sin(uint16_t angle)
+{
+    /* Second and fourth quarter mirror the first one. */
+    uint16_t phase = angle & 0x3fff;
+    if (angle & 0x4000) {
+        phase = 0x4000 - phase;
+    }
+
+    const uint16_t index = phase >> 6;
+    const uint16_t fraction = phase & 63;
+    int32_t value = SINE[index];
+
+    if (fraction) {
+        value += ((SINE[index + 1] - value) * fraction + 32) >> 6;
+    }
+
+    /* Second half of the wave is negative. */
+    return (angle & 0x8000) ? -value : value;
+}
+
+int32_t
+fixed_cos(uint16_t angle)
+{
+    return fixed_sin(angle + FIXED_TURN / 4);
+}
+
+/* Angle of n / d when 0 <= n <= d, at most one eighth of a turn. */
+static uint16_t
+octant(uint32_t n, uint32_t d)
+{
+    /* Keep the quotient within 32 bits. */
+    while (d >= (1 << 16)) {
+        n >>= 1;
+        d >>= 1;
+    }
+
+    const uint32_t ratio = (n << 16) / d;
+    const uint16_t index = ratio >> 8;
+    const uint16_t fraction = ratio & 255;
+
+    if (256 == index) {
+        return ATAN[256];
+    }
+    return ATAN[index] + (((ATAN[index + 1] - ATAN[index]) * fraction + 128) >> 8);
+}
+
+uint16_t
+fixed_atan2(int32_t y, int32_t x)
+{
+    const uint32_t ax = abs(x);
+    const uint32_t ay = abs(y);
+    uint16_t angle;
+
+    if (0 == ax && 0 == ay) {
+        return 0;
+    }
+
+    /* Reduce to the first octant, then unfold. */
+    if (ay <= ax) {
+        angle = octant(ay, ax);
+    } else {
+        angle = FIXED_TURN / 4 - octant(ax, ay);
+    }
+    if (x < 0) {
+        angle = FIXED_TURN / 2 - angle;
+    }
+    if (y < 0) {
+        angle = -angle;
+    }
+
+    return angle;
+}
+
+uint16_t
+fixed_isqrt(uint32_t n)
+{
+    uint32_t root = 0;
+    uint32_t bit = 1UL << 30;
+
+    while (bit > n) {
+        bit >>= 2;
+    }
+
+    while (bit) {
+        if (n >= root + bit) {
+            n -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+
+    return root;
+}
+
+uint32_t
+fixed_reciprocal(uint32_t x)
+{
+    if (x < 2) {
+        return UINT32_MAX;
+    }
+
+    /* Normalize to mantissa 1.0 ... 2.0 with 8 bit index and 16 bit fraction. */
+    const uint8_t exponent = 31 - __builtin_clz(x);
+    const uint32_t mantissa = x << (31 - exponent);
+    const uint16_t index = (mantissa >> 23) & 255;
+    const uint32_t fraction = (mantissa >> 7) & 0xffff;
+
+    const uint32_t step = RECIPROCAL[index] - RECIPROCAL[index + 1];
+    const uint32_t value = RECIPROCAL[index] - (uint32_t) (((uint64_t) step * fraction) >> 16);
+
+    /* 2^32 / x = 2 * (2^31 / mantissa) / 2^exponent */
+    return value >> (exponent - 1);
+}
@@ -0,0 +1,91 @@
+/*
+
+MIT No Attribution
+
+Copyright (c) 2020-2023 Mika Tuupola
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+-cut-
+
+SPDX-License-Identifier: MIT-0
+
+*/
+
+#ifndef _FIXED_H
+#define _FIXED_H
+
+#include "sdkconfig.h"
+
+#include <stdint.h>
+
+/*
+ * Angles are binary, a full turn is 65536 so that they wrap around in
+ * an uint16_t. Sine and cosine are Q15, one is 32768.
+ */
+#define FIXED_TURN          (65536)
+#define FIXED_SINE_SHIFT    (15)
+#define FIXED_SINE_ONE      (1 << FIXED_SINE_SHIFT)
+
+/* Binary angle of whole degrees, rounded. */
+#define FIXED_DEGREES(degrees) ((uint16_t) (((degrees) * FIXED_TURN + 180) / 360))
+
+/* One radian in binary angle units in Q16. */
+#define FIXED_RADIAN_Q16    (683565276LL)
+
+/*
+ * Tables generated with this module differ slightly from the floating
+ * point ones. Added to cache versions so that the two never mix.
+ */
+#ifdef CONFIG_EFFECTS_FIXED_POINT
+#define FIXED_VERSION       (0x10000)
+#else
+#define FIXED_VERSION       (0)
+#endif /* CONFIG_EFFECTS_FIXED_POINT */
+
+/* Binary angle of x / 2^shift radians. */
+static inline uint16_t
+fixed_radians(int32_t x, uint8_t shift)
+{
+    return ((int64_t) x * FIXED_RADIAN_Q16) >> (16 + shift);
+}
+
+/*
+ * Sine and cosine in Q15. Quarter wave table of 257 entries with linear
+ * interpolation, error is below 2 / 32768.
+ */
+int32_t fixed_sin(uint16_t angle);
+int32_t fixed_cos(uint16_t angle);
+
+/*
+ * Angle of the vector (x, y) as binary angle. Table of 257 entries for
+ * the first octant with linear interpolation, error is below 1.5 units
+ * which is 0.008 degrees. Returns zero for the zero vector.
+ */
+uint16_t fixed_atan2(int32_t y, int32_t x);
+
+/* Square root rounded down, exact. */
+uint16_t fixed_isqrt(uint32_t n);
+
+/*
+ * 2^32 / x rounded down, saturates to UINT32_MAX when x is zero or one.
+ * For x in Qn the result is 1 / x in Q(32 - n). Table of 257 entries
+ * with linear interpolation, relative error is below 2^-17 for results
+ * above 2^17. Smaller results are limited by rounding down.
+ */
+uint32_t fixed_reciprocal(uint32_t x);
+
+#endif /* _FIXED_H */
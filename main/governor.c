@@ -0,0 +1,114 @@
+/*
+
+MIT No Attribution
+
+Copyright (c) 2020-2023 Mika Tuupola
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+-cut-
+
+Keeps an effect at the finest render scale which still renders within
+the frame budget. Frame times are smoothed with a moving average of
+eight frames. Going coarser needs the average to exceed the budget.
+Going finer needs the cost at the finer scale, estimated from the pixel
+count, to stay under 7/8 of the budget. Upscaling costs the same at
+every scale so the estimate errs on the slow side, which widens the gap
+between the two thresholds. After each change the scale is held for a
+while so the average reflects the new scale.
+
+SPDX-License-Identifier: MIT-0
+
+*/
+
+#include <stdint.h>
+#include <string.h>
+
+#include "governor.h"
+
+void
+governor_init(governor_t *governor, uint16_t fps, uint8_t scale)
+{
+    memset(governor, 0, sizeof(governor_t));
+    governor->budget = 1000000 / fps;
+    governor->scale = scale < GOVERNOR_MIN_SCALE ? GOVERNOR_MIN_SCALE : scale;
+    if (governor->scale > GOVERNOR_MAX_SCALE) {
+        governor->scale = GOVERNOR_MAX_SCALE;
+    }
+    governor->hold = GOVERNOR_HOLD;
+}
+
+void
+governor_restart(governor_t *governor)
+{
+    memset(governor->spent, 0, sizeof(governor->spent));
+}
+
+/* Switch to given scale, scaling the average by the change in pixel count. */
+static void
+change(governor_t *governor, uint8_t scale)
+{
+    const uint8_t old = governor->scale;
+
+    governor->average = (uint64_t) governor->average * old * old / (scale * scale);
+    governor->scale = scale;
+    governor->hold = GOVERNOR_HOLD;
+}
+
+uint8_t
+governor_update(governor_t *governor, uint32_t us)
+{
+    const uint8_t scale = governor->scale;
+
+    governor->spent[scale] += us;
+
+    /* First frame after init or restart seeds the average. */
+    if (0 == governor->average) {
+        governor->average = us;
+    } else {
+        governor->average = governor->average + ((int32_t) us - (int32_t) governor->average) / 8;
+    }
+
+    if (governor->hold) {
+        governor->hold--;
+        return scale;
+    }
+
+    if (governor->average > governor->budget && scale < GOVERNOR_MAX_SCALE) {
+        change(governor, scale + 1);
+    } else if (scale > GOVERNOR_MIN_SCALE) {
+        const uint64_t finer = (uint64_t) governor->average * scale * scale / ((scale - 1) * (scale - 1));
+        if (finer < governor->budget * 7 / 8) {
+            change(governor, scale - 1);
+        }
+    }
+
+    return governor->scale;
+}
+
+uint8_t
+governor_share(governor_t const *governor, uint8_t scale)
+{
+    uint64_t total = 0;
+
+    for (uint8_t i = GOVERNOR_MIN_SCALE; i <= GOVERNOR_MAX_SCALE; i++) {
+        total += governor->spent[i];
+    }
+    if (0 == total || scale > GOVERNOR_MAX_SCALE) {
+        return 0;
+    }
+    return governor->spent[scale] * 100 / total;
+}
@@ -0,0 +1,68 @@
+/*
+
+MIT No Attribution
+
+Copyright (c) 2020-2023 Mika Tuupola
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+-cut-
+
+SPDX-License-Identifier: MIT-0
+
+*/
+
+#ifndef _GOVERNOR_H
+#define _GOVERNOR_H
+
+#include <stdint.h>
+
+/* Range of pixel sizes which can be configured, see SPAN_MAX_SIZE. */
+#define GOVERNOR_MIN_SCALE  (1)
+#define GOVERNOR_MAX_SCALE  (4)
+
+/* Frames to wait after a change before the next one. */
+#define GOVERNOR_HOLD       (16)
+
+/*
+ * Picks the render scale of one effect so that rendering a frame fits
+ * in the time budget of the target frame rate. Scale is the pixel size
+ * the effect renders at, larger is coarser and faster.
+ */
+typedef struct {
+    uint32_t budget;
+    uint32_t average;
+    uint16_t hold;
+    uint8_t scale;
+    /* Microseconds spent rendering at each scale since the restart. */
+    uint32_t spent[GOVERNOR_MAX_SCALE + 1];
+} governor_t;
+
+void governor_init(governor_t *governor, uint16_t fps, uint8_t scale);
+
+/* Forget the time spent at each scale, keeps the current scale. */
+void governor_restart(governor_t *governor);
+
+/*
+ * Account one frame which took given microseconds to render. Returns
+ * the scale for the next frame.
+ */
+uint8_t governor_update(governor_t *governor, uint32_t us);
+
+/* Share of the rendering time since the restart spent at given scale. */
+uint8_t governor_share(governor_t const *governor, uint8_t scale);
+
+#endif /* _GOVERNOR_H */
@@ -0,0 +1,237 @@
+/*
+
+MIT No Attribution
+
+Copyright (c) 2020-2023 Mika Tuupola
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+-cut-
+
+Texts are drawn into an overlay which covers only the bands above and
+below the clip window. Drawing happens only when some text changed,
+composing copies the finished bands over the frame with two blits. The
+task which sets the texts never touches the display.
+
+SPDX-License-Identifier: MIT-0
+
+*/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wchar.h>
+#include <hagl.h>
+
+#ifdef ESP_PLATFORM
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_heap_caps.h>
+#endif /* ESP_PLATFORM */
+
+#include "hud.h"
+#include "blit.h"
+
+typedef struct {
+    wchar_t text[HUD_TEXT_LENGTH];
+    int16_t x0;
+    int16_t y0;
+    hagl_color_t color;
+} field_t;
+
+/* Both bands in one buffer, bottom band right after the top band. */
+#define BAND_SIZE   (DISPLAY_WIDTH * HUD_HEIGHT * sizeof(hagl_color_t))
+
+static hagl_backend_t overlay;
+static hagl_backend_t const *target;
+static const uint8_t *font;
+
+#ifdef ESP_PLATFORM
+static portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+#define LOCK()      taskENTER_CRITICAL(&lock)
+#define UNLOCK()    taskEXIT_CRITICAL(&lock)
+#else
+/* Host builds are single threaded. */
+#define LOCK()
+#define UNLOCK()
+#endif /* ESP_PLATFORM */
+
+static field_t pending[HUD_FIELDS];
+static field_t shown[HUD_FIELDS];
+
+/* Rows between the bands are not stored, returns NULL for them. */
+static inline hagl_color_t *
+pixel(int16_t x0, int16_t y0)
+{
+    if (y0 >= HUD_HEIGHT) {
+        y0 -= DISPLAY_HEIGHT - 2 * HUD_HEIGHT;
+        if (y0 < HUD_HEIGHT) {
+            return NULL;
+        }
+    }
+    return (hagl_color_t *) overlay.buffer + DISPLAY_WIDTH * y0 + x0;
+}
+
+static void
+put_pixel(void *self, int16_t x0, int16_t y0, hagl_color_t color)
+{
+    hagl_color_t *ptr = pixel(x0, y0);
+
+    if (ptr) {
+        *ptr = color;
+    }
+}
+
+static hagl_color_t
+get_pixel(void *self, int16_t x0, int16_t y0)
+{
+    hagl_color_t *ptr = pixel(x0, y0);
+
+    return ptr ? *ptr : 0;
+}
+
+static hagl_color_t
+color(void *self, uint8_t r, uint8_t g, uint8_t b)
+{
+    return hagl_color(target, r, g, b);
+}
+
+static void
+blit(void *self, int16_t x0, int16_t y0, hagl_bitmap_t *src)
+{
+    uint8_t *ptr = src->buffer;
+
+    for (int16_t y = y0; y < y0 + src->height; y++) {
+        hagl_color_t *dst = pixel(x0, y);
+        if (dst) {
+            memcpy(dst, ptr, src->width * sizeof(hagl_color_t));
+        }
+        ptr += src->pitch;
+    }
+}
+
+static void
+hline(void *self, int16_t x0, int16_t y0, uint16_t width, hagl_color_t color)
+{
+    hagl_color_t *ptr = pixel(x0, y0);
+
+    while (ptr && width--) {
+        *(ptr++) = color;
+    }
+}
+
+static void
+vline(void *self, int16_t x0, int16_t y0, uint16_t height, hagl_color_t color)
+{
+    for (int16_t y = y0; y < y0 + height; y++) {
+        put_pixel(self, x0, y, color);
+    }
+}
+
+/* Redraw the overlay if any text changed. Returns true if redrawn. */
+static bool
+update()
+{
+    field_t fields[HUD_FIELDS];
+
+    LOCK();
+    memcpy(fields, pending, sizeof(fields));
+    UNLOCK();
+
+    if (0 == memcmp(fields, shown, sizeof(fields))) {
+        return false;
+    }
+    memcpy(shown, fields, sizeof(fields));
+
+    /* Zero is black also in RGB332. Texts change a few times a second */
+    /* at most so everything is redrawn. */
+    memset(overlay.buffer, 0, 2 * BAND_SIZE);
+    for (uint8_t i = 0; i < HUD_FIELDS; i++) {
+        if (shown[i].text[0]) {
+            hagl_put_text(&overlay, shown[i].text, shown[i].x0, shown[i].y0, shown[i].color, font);
+        }
+    }
+
+    return true;
+}
+
+bool
+hud_init(hagl_backend_t const *display, const uint8_t *typeface)
+{
+    memset(&overlay, 0, sizeof(hagl_backend_t));
+
+#ifdef ESP_PLATFORM
+    /* Sent straight to the display when there is no back buffer. */
+    overlay.buffer = heap_caps_calloc(2, BAND_SIZE, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+#else
+    overlay.buffer = calloc(2, BAND_SIZE);
+#endif /* ESP_PLATFORM */
+    if (NULL == overlay.buffer) {
+        return false;
+    }
+
+    target = display;
+    font = typeface;
+
+    overlay.width = DISPLAY_WIDTH;
+    overlay.height = DISPLAY_HEIGHT;
+    overlay.depth = DISPLAY_DEPTH;
+    overlay.put_pixel = put_pixel;
+    overlay.get_pixel = get_pixel;
+    overlay.color = color;
+    overlay.blit = blit;
+    overlay.hline = hline;
+    overlay.vline = vline;
+    overlay.clip.x0 = 0;
+    overlay.clip.y0 = 0;
+    overlay.clip.x1 = DISPLAY_WIDTH - 1;
+    overlay.clip.y1 = DISPLAY_HEIGHT - 1;
+
+    return true;
+}
+
+void
+hud_print(uint8_t field, const wchar_t *text, int16_t x0, int16_t y0, hagl_color_t color)
+{
+    LOCK();
+    wcsncpy(pending[field].text, text, HUD_TEXT_LENGTH - 1);
+    pending[field].x0 = x0;
+    pending[field].y0 = y0;
+    pending[field].color = color;
+    UNLOCK();
+}
+
+size_t
+hud_compose(hagl_backend_t const *display, bool changed)
+{
+    hagl_bitmap_t bitmap;
+
+    if (NULL == overlay.buffer) {
+        return 0;
+    }
+    if (!update() && changed) {
+        return 0;
+    }
+
+    /* Backend blits do not clip, the bands are outside the clip window. */
+    hagl_bitmap_init(&bitmap, DISPLAY_WIDTH, HUD_HEIGHT, DISPLAY_DEPTH, overlay.buffer);
+    blit_rows(display, 0, &bitmap);
+    hagl_bitmap_init(&bitmap, DISPLAY_WIDTH, HUD_HEIGHT, DISPLAY_DEPTH, overlay.buffer + BAND_SIZE);
+    blit_rows(display, DISPLAY_HEIGHT - HUD_HEIGHT, &bitmap);
+
+    return 2 * bitmap.size;
+}
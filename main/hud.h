@@ -0,0 +1,66 @@
+/*
+
+MIT No Attribution
+
+Copyright (c) 2020-2023 Mika Tuupola
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+-cut-
+
+SPDX-License-Identifier: MIT-0
+
+*/
+
+#ifndef _HUD_H
+#define _HUD_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <wchar.h>
+#include <hagl.h>
+
+/* Rows reserved for texts at the top and at the bottom of the display. */
+#define HUD_HEIGHT      (20)
+
+#define HUD_FIELDS      (4)
+#define HUD_TEXT_LENGTH (32)
+
+/*
+ * Allocate the overlay which holds both bands of texts. Texts are drawn
+ * with given font in colors of the display. Returns false if out of
+ * memory.
+ */
+bool hud_init(hagl_backend_t const *display, const uint8_t *font);
+
+/*
+ * Set the text of given field. Coordinates are display coordinates
+ * inside either of the bands. Only copies the text, it is drawn to the
+ * overlay by the next hud_compose() if it changed. Safe to call from
+ * any task.
+ */
+void hud_print(uint8_t field, const wchar_t *text, int16_t x0, int16_t y0, hagl_color_t color);
+
+/*
+ * Copy the overlay over both bands of the display. With changed set
+ * only copies if any text changed since the previous call. Call from
+ * the task which renders or sends the frames. Returns the number of
+ * bytes copied.
+ */
+size_t hud_compose(hagl_backend_t const *display, bool changed);
+
+#endif /* _HUD_H */
@@ -0,0 +1,286 @@
+/*
+
+MIT No Attribution
+
+Copyright (c) 2020-2023 Mika Tuupola
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+-cut-
+
+Eight bit indexed back buffer. Effects write palette indices instead
+of colors which halves the memory and the bandwidth needed for the
+back buffer. Indices are expanded to colors only when flushing, a few
+rows at a time into a small DMA capable buffer. Changing the palette
+changes the whole frame without touching the back buffer.
+
+SPDX-License-Identifier: MIT-0
+
+*/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <hagl.h>
+
+#ifdef ESP_PLATFORM
+#include <esp_heap_caps.h>
+#endif /* ESP_PLATFORM */
+
+#include "indexed.h"
+#include "blit.h"
+#include "kernel.h"
+
+static hagl_backend_t backend;
+static hagl_backend_t *target = NULL;
+static hagl_window_t window;
+static hagl_color_t *expanded;
+
+static hagl_color_t rgb332[256];
+static hagl_color_t identity[256];
+
+/* Palette given by the effect and the one used by flush. */
+static hagl_color_t const *pending = rgb332;
+static uint8_t pending_offset = 0;
+static hagl_color_t const *palette = rgb332;
+static uint8_t offset = 0;
+
+static void
+put_pixel(void *self, int16_t x0, int16_t y0, hagl_color_t color)
+{
+    backend.buffer[DISPLAY_WIDTH * y0 + x0] = color;
+}
+
+static hagl_color_t
+get_pixel(void *self, int16_t x0, int16_t y0)
+{
+    return backend.buffer[DISPLAY_WIDTH * y0 + x0];
+}
+
+static hagl_color_t
+color(void *self, uint8_t r, uint8_t g, uint8_t b)
+{
+    return (r & 0xe0) | ((g >> 3) & 0x1c) | (b >> 6);
+}
+
+static void
+blit(void *self, int16_t x0, int16_t y0, hagl_bitmap_t *src)
+{
+    uint8_t *dst = backend.buffer + DISPLAY_WIDTH * y0 + x0;
+    uint8_t *ptr = src->buffer;
+
+    for (int16_t y = 0; y < src->height; y++) {
+        const hagl_color_t *colors = (const hagl_color_t *) ptr;
+        for (int16_t x = 0; x < src->width; x++) {
+            dst[x] = colors[x];
+        }
+        dst += DISPLAY_WIDTH;
+        ptr += src->pitch;
+    }
+}
+
+static void
+hline(void *self, int16_t x0, int16_t y0, uint16_t width, hagl_color_t color)
+{
+    memset(backend.buffer + DISPLAY_WIDTH * y0 + x0, color, width);
+}
+
+static void
+vline(void *self, int16_t x0, int16_t y0, uint16_t height, hagl_color_t color)
+{
+    uint8_t *ptr = backend.buffer + DISPLAY_WIDTH * y0 + x0;
+
+    while (height--) {
+        *ptr = color;
+        ptr += DISPLAY_WIDTH;
+    }
+}
+
+/* Expand rows y0 ... y1 - 1 with given palette and send them. */
+static size_t
+send(int16_t y0, int16_t y1, hagl_color_t const *colors, uint8_t rotate)
+{
+    hagl_bitmap_t bitmap;
+    size_t bytes = 0;
+
+    for (; y0 < y1; y0 += INDEXED_LINES) {
+        const uint16_t height = y0 + INDEXED_LINES < y1 ? INDEXED_LINES : y1 - y0;
+
+        /* Full width rows are contiguous, expand them with one call. */
+        kernel_lookup8(expanded, backend.buffer + DISPLAY_WIDTH * y0, colors, rotate, DISPLAY_WIDTH * height);
+        hagl_bitmap_init(&bitmap, DISPLAY_WIDTH, height, DISPLAY_DEPTH, (uint8_t *) expanded);
+        blit_rows(target, y0, &bitmap);
+        bytes += bitmap.size;
+    }
+
+    return bytes;
+}
+
+static size_t
+flush(void *self)
+{
+    size_t bytes = 0;
+
+    /* Texts above and below the effect are always drawn in RGB332. */
+    bytes += send(0, window.y0, rgb332, 0);
+    bytes += send(window.y0, window.y1 + 1, palette, offset);
+    bytes += send(window.y1 + 1, DISPLAY_HEIGHT, rgb332, 0);
+
+    return bytes;
+}
+
+static void
+close(void *self)
+{
+    free(backend.buffer);
+    free(expanded);
+    backend.buffer = NULL;
+    expanded = NULL;
+    hagl_close(target);
+    target = NULL;
+}
+
+hagl_backend_t *
+indexed_init(hagl_backend_t *hal)
+{
+    memset(&backend, 0, sizeof(hagl_backend_t));
+
+    backend.buffer = calloc(DISPLAY_WIDTH * DISPLAY_HEIGHT, sizeof(uint8_t));
+#ifdef ESP_PLATFORM
+    /* SPI master can send straight from DMA capable memory. */
+    expanded = heap_caps_malloc(DISPLAY_WIDTH * INDEXED_LINES * sizeof(hagl_color_t), MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+#else
+    expanded = malloc(DISPLAY_WIDTH * INDEXED_LINES * sizeof(hagl_color_t));
+#endif /* ESP_PLATFORM */
+    if (NULL == backend.buffer || NULL == expanded) {
+        free(backend.buffer);
+        free(expanded);
+        return NULL;
+    }
+
+    target = hal;
+    window = hal->clip;
+
+    for (uint16_t i = 0; i < 256; i++) {
+        /* Three bits of red and green, two bits of blue. */
+        const uint8_t r = (i >> 5) * 255 / 7;
+        const uint8_t g = ((i >> 2) & 0x07) * 255 / 7;
+        const uint8_t b = (i & 0x03) * 255 / 3;
+        rgb332[i] = hagl_color(target, r, g, b);
+        identity[i] = i;
+    }
+    pending = palette = rgb332;
+    pending_offset = offset = 0;
+
+    backend.width = DISPLAY_WIDTH;
+    backend.height = DISPLAY_HEIGHT;
+    /* Colors are passed in as usual, only the storage is eight bits. */
+    backend.depth = DISPLAY_DEPTH;
+    backend.put_pixel = put_pixel;
+    backend.get_pixel = get_pixel;
+    backend.color = color;
+    backend.blit = blit;
+    backend.hline = hline;
+    backend.vline = vline;
+    backend.flush = flush;
+    backend.close = close;
+    backend.clip = hal->clip;
+
+    return &backend;
+}
+
+hagl_backend_t *
+indexed_target(hagl_backend_t const *display)
+{
+    return &backend == display ? target : NULL;
+}
+
+hagl_color_t const *
+indexed_identity()
+{
+    return identity;
+}
+
+void
+indexed_palette(hagl_color_t const *colors, uint8_t rotate)
+{
+    pending = colors ? colors : rgb332;
+    pending_offset = rotate;
+}
+
+void
+indexed_commit()
+{
+    palette = pending;
+    offset = pending_offset;
+}
+
+/* Four most significant bits of each channel. */
+static inline uint16_t
+key(hagl_color_t color, bool swap)
+{
+    if (swap) {
+        color = (color >> 8) | (color << 8);
+    }
+    return (color >> 12) << 8 | ((color >> 7) & 0x0f) << 4 | ((color >> 1) & 0x0f);
+}
+
+static inline uint16_t
+distance(uint16_t a, uint16_t b)
+{
+    const int16_t dr = (a >> 8) - (b >> 8);
+    const int16_t dg = ((a >> 4) & 0x0f) - ((b >> 4) & 0x0f);
+    const int16_t db = (a & 0x0f) - (b & 0x0f);
+    return dr * dr + dg * dg + db * db;
+}
+
+void
+indexed_quantize(hagl_color_t *dst, hagl_color_t *colors, hagl_color_t const *src, size_t count)
+{
+    /* Quantized in RGB order, HAL may store colors swapped. */
+    const bool swap = 0x001f != hagl_color(target, 0, 0, 255);
+    uint16_t keys[256];
+    uint16_t used = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        const uint16_t wanted = key(src[i], swap);
+        uint16_t best = 0;
+
+        /* Linear search is fast enough for textures at init time. */
+        while (best < used && keys[best] != wanted) {
+            best++;
+        }
+        if (best == used && used < 256) {
+            keys[used] = wanted;
+            colors[used++] = src[i];
+        } else if (best == used) {
+            /* Palette is full, use the closest entry. */
+            best = 0;
+            for (uint16_t j = 1; j < used; j++) {
+                if (distance(keys[j], wanted) < distance(keys[best], wanted)) {
+                    best = j;
+                }
+            }
+        }
+        dst[i] = best;
+    }
+
+    /* Unused entries are never looked up, keep them defined anyway. */
+    for (uint16_t i = used; i < 256; i++) {
+        colors[i] = colors[0];
+    }
+}
@@ -0,0 +1,80 @@
+/*
+
+MIT No Attribution
+
+Copyright (c) 2020-2023 Mika Tuupola
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+-cut-
+
+SPDX-License-Identifier: MIT-0
+
+*/
+
+#ifndef _INDEXED_H
+#define _INDEXED_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <hagl.h>
+
+/* Rows expanded to HAL colors and sent to the HAL at a time. */
+#define INDEXED_LINES   (8)
+
+/*
+ * Wrap a HAL which has no back buffer. Returns a backend with an eight
+ * bit back buffer where every pixel is an index to a 256 color palette.
+ * Colors passed to the backend are stored as indices, hagl_color()
+ * returns RGB332 indices which the default palette maps back to RGB.
+ * Flushing expands the indices to HAL colors a few rows at a time and
+ * returns the number of bytes sent. Rows of the clip window the HAL has
+ * when this is called use the palette set with indexed_palette(), rows
+ * above and below it always use RGB332. Returns NULL if out of memory.
+ */
+hagl_backend_t *indexed_init(hagl_backend_t *hal);
+
+/*
+ * Returns the HAL behind display if display is the indexed back buffer,
+ * NULL otherwise. Palettes are in the color format of this HAL.
+ */
+hagl_backend_t *indexed_target(hagl_backend_t const *display);
+
+/* Palette which maps every index to itself. */
+hagl_color_t const *indexed_identity();
+
+/*
+ * Use given 256 colors inside the clip window for the next frame,
+ * offset is added to every index before the lookup. NULL selects the default RGB332 palette.
+ * Palette must stay valid until the next call.
+ */
+void indexed_palette(hagl_color_t const *palette, uint8_t offset);
+
+/*
+ * Make the palette given above the one used by flush. Call between the
+ * end of one flush and the start of the next one.
+ */
+void indexed_commit();
+
+/*
+ * Convert count HAL colors into indices to a palette of at most 256
+ * colors. Indices are written as colors so the result can be used in
+ * place of the source. Colors which differ only in the low bits share
+ * an entry.
+ */
+void indexed_quantize(hagl_color_t *dst, hagl_color_t *palette, hagl_color_t const *src, size_t count);
+
+#endif /* _INDEXED_H */
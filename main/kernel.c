@@ -0,0 +1,209 @@
+/*
+
+MIT No Attribution
+
+Copyright (c) 2020-2023 Mika Tuupola
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+
+-cut-
+
+Bulk pixel loops shared by the effects. Portable versions work on 32
+bits at a time, four bytes or two RGB565 pixels per operation. On the
+ESP32-S3 fills and pixel doubling can use the 128 bit PIE vector unit
+instead. The PIE versions use q0 and q1 as scratch registers. They are
+off by default until they have been built with the ESP32-S3 toolchain
+and checked against the portable versions.
+
+SPDX-License-Identifier: MIT-0
+
+*/
+
+#include <stddef.h>
+#include <stdint.h>
+#include <hagl.h>
+
+#ifdef ESP_PLATFORM
+#include "sdkconfig.h"
+#endif /* ESP_PLATFORM */
+
+#include "kernel.h"
+
+#if defined(CONFIG_IDF_TARGET_ESP32S3) && defined(CONFIG_EFFECTS_KERNEL_PIE)
+#define KERNEL_PIE
+#endif
+
+/* Word access to byte and pixel buffers without breaking aliasing rules. */
+typedef uint32_t __attribute__((may_alias)) word_t;
+
+#define ALIGNED(ptr, size) (0 == ((uintptr_t) (ptr) & ((size) - 1)))
+
+/* Adds b to each byte of a without carry spilling to the next byte. */
+static inline uint32_t
+add8x4(uint32_t a, uint32_t b)
+{
+    const uint32_t sum = (a & 0x7f7f7f7f) + (b & 0x7f7f7f7f);
+    return sum ^ ((a ^ b) & 0x80808080);
+}
+
+/* Pixel pair as stored by a little endian word write. */
+static inline uint32_t
+pair(hagl_color_t first, hagl_color_t second)
+{
+    return first | (uint32_t) second << 16;
+}
+
+void
+kernel_fill16(hagl_color_t *dst, hagl_color_t color, size_t count)
+{
+#ifdef KERNEL_PIE
+    while (count && !ALIGNED(dst, 16)) {
+        *(dst++) = color;
+        count--;
+    }
+    size_t blocks = count / 8;
+    if (blocks) {
+        /* Broadcast color to all eight lanes and store 16 bytes at a time. */
+        __asm__ volatile (
+            "ee.vldbc.16 q0, %[color]\n"
+            "1:\n"
+            "ee.vst.128.ip q0, %[dst], 16\n"
+            "addi %[blocks], %[blocks], -1\n"
+            "bnez %[blocks], 1b\n"
+            : [dst] "+r" (dst), [blocks] "+r" (blocks)
+            : [color] "r" (&color)
+            : "memory"
+        );
+        count %= 8;
+    }
+#endif /* KERNEL_PIE */
+
+    if (count && !ALIGNED(dst, 4)) {
+        *(dst++) = color;
+        count--;
+    }
+
+    const uint32_t both = pair(color, color);
+    word_t *ptr = (word_t *) dst;
+    while (count >= 8) {
+        ptr[0] = both;
+        ptr[1] = both;
+        ptr[2] = both;
+        ptr[3] = both;
+        ptr += 4;
+        count -= 8;
+    }
+    while (count >= 2) {
+        *(ptr++) = both;
+        count -= 2;
+    }
+    if (count) {
+        *((hagl_color_t *) ptr) = color;
+    }
+}
+
+void
+kernel_double16(hagl_color_t *dst, const hagl_color_t *src, size_t count)
+{
+#ifdef KERNEL_PIE
+    size_t blocks = count / 8;
+    if (blocks && ALIGNED(src, 16) && ALIGNED(dst, 16)) {
+        /* Zip eight pixels with themselves into sixteen. */
+        __asm__ volatile (
+            "1:\n"
+            "ee.vld.128.ip q0, %[src], 16\n"
+            "ee.orq q1, q0, q0\n"
+            "ee.vzip.16 q0, q1\n"
+            "ee.vst.128.ip q0, %[dst], 16\n"
+            "ee.vst.128.ip q1, %[dst], 16\n"
+            "addi %[blocks], %[blocks], -1\n"
+            "bnez %[blocks], 1b\n"
+            : [dst] "+r" (dst), [src] "+r" (src), [blocks] "+r" (blocks)
+            :
+            : "memory"
+        );
+        count %= 8;
+    }
+#endif /* KERNEL_PIE */
+
+    /* Doubled pixels are always whole pairs, stores need aligned dst. */
+    if (!ALIGNED(dst, 4)) {
+        while (count--) {
+            *(dst++) = *src;
+            *(dst++) = *(src++);
+        }
+        return;
+    }
+
+    word_t *ptr = (word_t *) dst;
+    if (count && !ALIGNED(src, 4)) {
+        *(ptr++) = pair(*src, *src);
+        src++;
+        count--;
+    }
+
+    /* One load and two stores per two source pixels. */
+    const word_t *in = (const word_t *) src;
+    while (count >= 2) {
+        const uint32_t word = *(in++);
+        *(ptr++) = (word & 0xffff) * 0x00010001;
+        *(ptr++) = (word >> 16) * 0x00010001;
+        count -= 2;
+    }
+    if (count) {
+        src = (const hagl_color_t *) in;
+        *ptr = pair(*src, *src);
+    }
+}
+
+void
+kernel_lookup8(hagl_color_t *dst, const uint8_t *src, const hagl_color_t *palette, uint8_t offset, size_t count)
+{
+    /* There is no vector gather, both paths look up one byte at a time. */
+    while (count && !ALIGNED(src, 4)) {
+        *(dst++) = palette[(uint8_t) (*(src++) + offset)];
+        count--;
+    }
+
+    const uint32_t offsets = offset * 0x01010101u;
+    const word_t *in = (const word_t *) src;
+
+    if (ALIGNED(dst, 4)) {
+        word_t *ptr = (word_t *) dst;
+        while (count >= 4) {
+            const uint32_t index = add8x4(*(in++), offsets);
+            *(ptr++) = pair(palette[index & 0xff], palette[(index >> 8) & 0xff]);
+            *(ptr++) = pair(palette[(index >> 16) & 0xff], palette[index >> 24]);
+            count -= 4;
+        }
+        dst = (hagl_color_t *) ptr;
+    } else {
+        while (count >= 4) {
+            const uint32_t index = add8x4(*(in++), offsets);
+            *(dst++) = palette[index & 0xff];
+            *(dst++) = palette[(index >> 8) & 0xff];
+            *(dst++) = palette[(index >> 16) & 0xff];
+            *(dst++) = palette[index >> 24];
+            count -= 4;
+        }
+    }
+
+    src = (const uint8_t *) in;
+    while (count--) {
+        *(dst++) = palette[(uint8_t) (*(src++) + offset)];
+    }
+}
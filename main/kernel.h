@@ -0,0 +1,54 @@
+/*
+
+MIT No Attribution
+
+Copyright (c) 2020-2023 Mika Tuupola
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+
+-cut-
+
+SPDX-License-Identifier: MIT-0
+
+*/
+
+#ifndef _KERNEL_H
+#define _KERNEL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <hagl.h>
+
+/*
+ * Row buffers passed to the kernels should be declared with this. The
+ * vector paths are taken only when buffers are 16 byte aligned.
+ */
+#define KERNEL_ALIGNED __attribute__((aligned(16)))
+
+/* Set count pixels to color. */
+void kernel_fill16(hagl_color_t *dst, hagl_color_t color, size_t count);
+
+/* Write every source pixel twice. Destination holds 2 * count pixels. */
+void kernel_double16(hagl_color_t *dst, const hagl_color_t *src, size_t count);
+
+/*
+ * Look up count colors from a 256 color palette. Offset is added to
+ * every index and the sum wraps around at 256.
+ */
+void kernel_lookup8(hagl_color_t *dst, const uint8_t *src, const hagl_color_t *palette, uint8_t offset, size_t count);
+
+#endif /* _KERNEL_H */
@@ -27,6 +27,8 @@ SPDX-License-Identifier: MIT-0
 
 #include "sdkconfig.h"
 
+#include <math.h>
+#include <stdatomic.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -35,6 +37,7 @@ SPDX-License-Identifier: MIT-0
 #include <freertos/task.h>
 #include <freertos/event_groups.h>
 #include <esp_log.h>
+#include <esp_timer.h>
 
 #ifdef CONFIG_DEVICE_HAS_AXP192
 #include <i2c_helper.h>
@@ -55,6 +58,27 @@ SPDX-License-Identifier: MIT-0
 #include "plasma.h"
 #include "rotozoom.h"
 #include "deform.h"
+#include "sineplasma.h"
+#include "profile.h"
+#include "parallel.h"
+#include "ring.h"
+#include "dirty.h"
+#include "hud.h"
+#include "indexed.h"
+#include "strip.h"
+#include "arena.h"
+#include "asset.h"
+#include "cache.h"
+#include "governor.h"
+
+/* Either the HAL, dirty row tracking or indexed mode provides the back buffer. */
+#if defined(HAGL_HAS_HAL_BACK_BUFFER) || defined(CONFIG_EFFECTS_DIRTY_ROWS) || defined(CONFIG_EFFECTS_INDEXED)
+#define EFFECTS_HAS_BACK_BUFFER
+#endif
+
+#if defined(CONFIG_EFFECTS_STRIPS) && CONFIG_EFFECTS_STRIP_LINES % STRIP_ALIGN
+#error "Lines per strip must be a multiple of 12"
+#endif
 
 static const char *TAG = "main";
 static EventGroupHandle_t event;
@@ -63,128 +87,371 @@ static aps_instance_t bps;
 static uint8_t effect = 0;
 static hagl_backend_t *display;
 
+/* Rendered frames, or strips when rendering in strips, waiting for flush. */
+static ring_t frames;
+static uint32_t dropped = 0;
+static uint32_t late = 0;
+
 static const uint8_t RENDER_FINISHED = (1 << 0);
+static const uint8_t FLUSH_FINISHED = (1 << 1);
+static const uint8_t EFFECT_SWITCHED = (1 << 2);
+
+static const uint32_t SWITCH_MS = 10000;
+static const uint32_t PREWARM_MS = 3000;
+
+/*
+ * Switch task runs effect init which writes the table cache to flash
+ * and quantizes textures for the indexed backend, both use the stack.
+ */
+static const uint32_t SWITCH_STACK = 6144;
+
+/* Effect the demo task should switch to, written by switch task. */
+static atomic_uint upcoming = 0;
+
+/* First frame of the new effect, announced when flushed. */
+static uint32_t switched = 0;
+static atomic_bool switching = false;
 
-static char demo[4][32] = {
+#ifdef CONFIG_EFFECTS_STRIPS
+/* Renders into the strip buffers, NULL if they could not be allocated. */
+static hagl_backend_t *strips = NULL;
+static uint32_t sequence = 0;
+/* Microseconds render_strips() waited for a free strip this frame. */
+static int64_t stalled = 0;
+#endif /* CONFIG_EFFECTS_STRIPS */
+
+#ifdef CONFIG_EFFECTS_GOVERNOR
+/* Pixel size of the effects which can change it, unused ones are zero. */
+static governor_t governors[5];
+#endif /* CONFIG_EFFECTS_GOVERNOR */
+
+static char demo[5][32] = {
     "3 METABALLS   ",
     "PALETTE PLASMA",
     "ROTOZOOM      ",
     "PLANE DEFORM     ",
+    "SINE PLASMA   ",
 };
 
 /*
  * Flushes the backbuffer to the display. Needed when using
- * double or triple buffering.
+ * double or triple buffering. Sleeps until a frame has been
+ * rendered and frees its slot in the ring once flushed.
  */
 void
 flush_task(void *params)
 {
+    uint32_t expected = 0;
+    frame_t *frame;
+
+    PROFILE_START(wait);
+
     while (1) {
         size_t bytes = 0;
 
-        EventBits_t bits = xEventGroupWaitBits(
-            event,
-            RENDER_FINISHED,
-            pdTRUE,
-            pdFALSE,
-            0
-        );
+        /* Display had to wait for the renderer. */
+        if (ring_empty(&frames)) {
+            late++;
+        }
+        while (NULL == (frame = ring_front(&frames))) {
+            xEventGroupWaitBits(
+                event,
+                RENDER_FINISHED,
+                pdTRUE,
+                pdFALSE,
+                portMAX_DELAY
+            );
+        }
+        PROFILE_END(PROFILE_WAIT, wait);
+
+        /* Gap in numbers means renderer dropped frames. */
+        const uint32_t number = frame->number;
+        dropped += number - expected;
+        expected = number + 1;
+
+        /* Blocks until the SPI DMA transfer has completed. */
+        PROFILE_START(flush);
+        bytes = hagl_flush(display);
+        PROFILE_END(PROFILE_FLUSH, flush);
+
+        ring_pop(&frames);
+        xEventGroupSetBits(event, FLUSH_FINISHED);
+
+        if (atomic_load(&switching) && number >= switched) {
+            atomic_store(&switching, false);
+            xEventGroupSetBits(event, EFFECT_SWITCHED);
+        }
+
+        aps_update(&bps, bytes);
+        fps_update(&fps);
+        PROFILE_RESTART(wait);
+    }
+
+    vTaskDelete(NULL);
+}
+
+#ifdef CONFIG_EFFECTS_STRIPS
+/*
+ * Sends strips to the display as soon as they are rendered. Demo task
+ * renders the next strip meanwhile, so SPI is kept busy as long as
+ * rendering keeps up.
+ */
+void
+strip_task(void *params)
+{
+    const uint16_t count = strip_count();
+    size_t bytes = 0;
+    frame_t *strip;
+
+    while (1) {
+        while (NULL == (strip = ring_front(&frames))) {
+            xEventGroupWaitBits(
+                event,
+                RENDER_FINISHED,
+                pdTRUE,
+                pdFALSE,
+                portMAX_DELAY
+            );
+        }
 
-        /* Flush only when RENDER_FINISHED is set. */
-        if ((bits & RENDER_FINISHED) != 0 ) {
-            bytes = hagl_flush(display);
+        /* Blocks until the SPI DMA transfer has completed. */
+        const uint32_t number = strip->number;
+        bytes += strip_send(number % STRIP_SLOTS);
+
+        ring_pop(&frames);
+        xEventGroupSetBits(event, FLUSH_FINISHED);
+
+        /* Last strip completes the frame, texts go between frames. */
+        if (count - 1 == number % count) {
+            PROFILE_START(hud);
+            bytes += hud_compose(display, true);
+            PROFILE_END(PROFILE_HUD, hud);
             aps_update(&bps, bytes);
             fps_update(&fps);
+            bytes = 0;
         }
     }
 
     vTaskDelete(NULL);
 }
 
+/* Render one frame strip by strip, waiting for a free strip buffer. */
+static void
+render_strips(render_rows_t *rows)
+{
+    for (uint16_t i = 0; i < strip_count(); i++) {
+        int16_t y0, y1;
+
+        PROFILE_START(stall);
+        const int64_t waited = esp_timer_get_time();
+        while (ring_full(&frames)) {
+            xEventGroupWaitBits(
+                event,
+                FLUSH_FINISHED,
+                pdTRUE,
+                pdFALSE,
+                portMAX_DELAY
+            );
+        }
+        stalled += esp_timer_get_time() - waited;
+        PROFILE_END(PROFILE_STALL, stall);
+
+        strip_begin(sequence % STRIP_SLOTS, i, &y0, &y1);
+        rows(strips, y0, y1);
+
+        /* Cannot fail, a free strip buffer was waited for above. */
+        frame_t strip = { .number = sequence++ };
+        if (!ring_push(&frames, &strip)) {
+            ESP_LOGE(TAG, "No free slot for strip %lu", strip.number);
+        }
+        xEventGroupSetBits(event, RENDER_FINISHED);
+    }
+}
+#endif /* CONFIG_EFFECTS_STRIPS */
+
+/* Render one frame of the current effect. */
+static void
+render_frame(render_rows_t *rows)
+{
+#ifdef CONFIG_EFFECTS_STRIPS
+    if (strips) {
+        render_strips(rows);
+        return;
+    }
+#endif /* CONFIG_EFFECTS_STRIPS */
+    parallel_render(display, rows);
+}
+
+#ifdef CONFIG_EFFECTS_GOVERNOR
+/*
+ * Pick the pixel size of the next frame from the time it took to
+ * render this one. Time spent waiting for a free strip is SPI time
+ * which no pixel size wins back.
+ */
+static void
+govern(int64_t us)
+{
+#ifdef CONFIG_EFFECTS_STRIPS
+    us -= stalled;
+    stalled = 0;
+#endif /* CONFIG_EFFECTS_STRIPS */
+    switch(effect) {
+        case 0:
+            metaballs_scale(governor_update(&governors[0], us));
+            break;
+        case 2:
+            rotozoom_scale(governor_update(&governors[2], us));
+            break;
+    }
+}
+#endif /* CONFIG_EFFECTS_GOVERNOR */
+
 /*
- * Update the displayed fps and kbps statistics every 250ms
+ * Update the displayed fps and kbps statistics every 250ms. Only sets
+ * the texts, they are drawn into the overlay by the demo task.
  */
- void
- stats_task(void *params)
- {
+void
+stats_task(void *params)
+{
     hagl_color_t green = hagl_color(display, 0, 255, 0);
-    wchar_t message[128];
+    wchar_t message[HUD_TEXT_LENGTH];
 
     while (1) {
         /* Print the message on top left corner. */
-        swprintf(message, sizeof(message), u"%s    ", demo[effect]);
-        hagl_set_clip(display, 0, 0, DISPLAY_WIDTH - 1, DISPLAY_HEIGHT - 1);
-        hagl_put_text(display, message, 4, 4, green, font6x9);
+        swprintf(message, HUD_TEXT_LENGTH, u"%s", demo[effect]);
+        hud_print(0, message, 4, 4, green);
 
         /* Print the message on lower left corner. */
-        swprintf(message, sizeof(message), u"%.*f FPS  ", 0, fps.current);
-        hagl_put_text(display, message, 4, DISPLAY_HEIGHT - 14, green, font6x9);
+        swprintf(message, HUD_TEXT_LENGTH, u"%ld FPS", lroundf(fps.current));
+        hud_print(1, message, 4, DISPLAY_HEIGHT - 14, green);
 
         /* Print the message on lower right corner. */
-        swprintf(message, sizeof(message), u"%.*f KBPS  ", 0, bps.current / 1000);
-        hagl_put_text(display, message, DISPLAY_WIDTH - 60, DISPLAY_HEIGHT - 14, green, font6x9);
+        swprintf(message, HUD_TEXT_LENGTH, u"%ld KBPS", lroundf(bps.current / 1000));
+        hud_print(2, message, DISPLAY_WIDTH - 60, DISPLAY_HEIGHT - 14, green);
 
-        hagl_set_clip(display, 0, 20, DISPLAY_WIDTH - 1, DISPLAY_HEIGHT - 21);
+#ifdef CONFIG_EFFECTS_GOVERNOR
+        /* Print the pixel size on top right corner. */
+        const uint8_t scale = governors[effect].scale;
+        swprintf(message, HUD_TEXT_LENGTH, scale ? u"%dX" : u"", scale);
+        hud_print(3, message, DISPLAY_WIDTH - 16, 4, green);
+#endif /* CONFIG_EFFECTS_GOVERNOR */
 
         vTaskDelay(250 / portTICK_PERIOD_MS);
     }
 
-     vTaskDelete(NULL);
- }
+    vTaskDelete(NULL);
+}
 
 /*
- * Changes the effect every 10 seconds.
+ * Copy the texts over the frame which was just rendered. HAL back
+ * buffers alternate so they need the texts every frame, everything else
+ * keeps them until they change. Strip task sends them between frames.
+ */
+static void
+render_hud()
+{
+#ifdef CONFIG_EFFECTS_STRIPS
+    if (strips) {
+        return;
+    }
+#endif /* CONFIG_EFFECTS_STRIPS */
+    PROFILE_START(hud);
+#ifdef HAGL_HAS_HAL_BACK_BUFFER
+    hud_compose(display, false);
+#else
+    hud_compose(display, true);
+#endif /* HAGL_HAS_HAL_BACK_BUFFER */
+    PROFILE_END(PROFILE_HUD, hud);
+}
+
+/*
+ * Initializes given effect. Must not touch the state of the effect
+ * which is currently rendered.
+ */
+static void
+effect_init(uint8_t index)
+{
+    switch(index) {
+        case 0:
+            metaballs_init(display);
+            break;
+        case 1:
+            plasma_init(display);
+            break;
+        case 2:
+            rotozoom_init(display);
+            break;
+        case 3:
+            deform_init(display);
+            break;
+        case 4:
+            sineplasma_init(display);
+            break;
+    }
+}
+
+/*
+ * Changes the effect every 10 seconds. Next effect is initialized
+ * a few seconds before the switch while the current one is still
+ * running, so there is no freeze when switching.
  */
 void
 switch_task(void *params)
 {
+    TickType_t wake = xTaskGetTickCount();
+
     while (1) {
-        /* Print the message in the console. */
-        ESP_LOGI(TAG, "%s %.*f FPS", demo[effect], 1, fps.current);
+        xTaskDelayUntil(&wake, pdMS_TO_TICKS(SWITCH_MS - PREWARM_MS));
 
-        hagl_clear(display);
-        hagl_flush(display);
+        const uint8_t next = (effect + 1) % 5;
 
-        switch(effect) {
-            case 0:
-                //metaballs_close();
-                break;
-            case 1:
-                plasma_close();
-                break;
-            case 2:
-                //rotozoom_close();
-                break;
-            case 3:
-                deform_close();
-                break;
-        }
+        /* Demo task has not used this end of the arena since last switch. */
+        int64_t start = esp_timer_get_time();
+        arena_flip();
+        effect_init(next);
+        ESP_LOGI(TAG, "Prepared %s in %lld us", demo[next], esp_timer_get_time() - start);
+        ESP_LOGD(TAG, "Switch task stack %u bytes unused", uxTaskGetStackHighWaterMark(NULL));
 
-        effect = (effect + 1) % 4;
+        xTaskDelayUntil(&wake, pdMS_TO_TICKS(PREWARM_MS));
 
-        switch(effect) {
-            case 0:
-                metaballs_init(display);
-                ESP_LOGI(TAG, "Heap after metaballs init: %ld", esp_get_free_heap_size());
-                break;
-            case 1:
-                plasma_init(display);
-                ESP_LOGI(TAG, "Heap after plasma init: %ld", esp_get_free_heap_size());
-                break;
-            case 2:
-                rotozoom_init(display);
-                ESP_LOGI(TAG, "Heap after rotozoom init: %ld", esp_get_free_heap_size());
-                break;
-            case 3:
-                deform_init(display);
-                ESP_LOGI(TAG, "Heap after deform init: %ld", esp_get_free_heap_size());
-                break;
+        /* Print the message in the console. */
+        ESP_LOGI(
+            TAG, "%s %.*f FPS, %ld dropped, %ld late",
+            demo[effect], 1, fps.current, dropped, late
+        );
+        PROFILE_DUMP(demo[effect]);
+#ifdef CONFIG_EFFECTS_GOVERNOR
+        governor_t const *governor = &governors[effect];
+        if (governor->scale) {
+            ESP_LOGI(
+                TAG, "%s pixel size %d, time at 1: %d%%, 2: %d%%, 3: %d%%, 4: %d%%",
+                demo[effect], governor->scale,
+                governor_share(governor, 1),
+                governor_share(governor, 2),
+                governor_share(governor, 3),
+                governor_share(governor, 4)
+            );
         }
+#endif /* CONFIG_EFFECTS_GOVERNOR */
+
+        /* Demo task picks the new effect between two frames. */
+        start = esp_timer_get_time();
+        xEventGroupClearBits(event, EFFECT_SWITCHED);
+        atomic_store(&upcoming, next);
+        xEventGroupWaitBits(
+            event,
+            EFFECT_SWITCHED,
+            pdTRUE,
+            pdFALSE,
+            portMAX_DELAY
+        );
+        ESP_LOGI(TAG, "Switch to %s first frame in %lld us", demo[next], esp_timer_get_time() - start);
 
         aps_reset(&bps);
         fps_reset(&fps);
-
-        vTaskDelay(10000 / portTICK_PERIOD_MS);
+        dropped = 0;
+        late = 0;
+        PROFILE_RESET();
     }
 
     vTaskDelete(NULL);
@@ -196,31 +463,116 @@ switch_task(void *params)
 void
 demo_task(void *params)
 {
-    /* Avoid waiting when running for the first time. */
-    xEventGroupSetBits(event, RENDER_FINISHED);
+    uint32_t number = 0;
 
     while (1) {
+        /* Swap only between frames, new effect was initialized already. */
+        if (effect != atomic_load(&upcoming)) {
+            effect = atomic_load(&upcoming);
+            switched = number;
+            atomic_store(&switching, true);
+#ifdef CONFIG_EFFECTS_INDEXED
+            /* Effects with their own palette set it when animating. */
+            indexed_palette(NULL, 0);
+#endif /* CONFIG_EFFECTS_INDEXED */
+#ifdef CONFIG_EFFECTS_GOVERNOR
+            /* Pixel size carries over, time at each size is per run. */
+            governor_restart(&governors[effect]);
+#endif /* CONFIG_EFFECTS_GOVERNOR */
+        }
+
+        PROFILE_START(animate);
         switch(effect) {
             case 0:
                 metaballs_animate();
-                metaballs_render(display);
                 break;
             case 1:
                 plasma_animate();
-                plasma_render(display);
                 break;
             case 2:
                 rotozoom_animate();
-                rotozoom_render(display);
                 break;
             case 3:
                 deform_animate();
-                deform_render(display);
                 break;
+            case 4:
+                sineplasma_animate();
+                break;
+        }
+        PROFILE_END(PROFILE_ANIMATE, animate);
+
+#if defined(EFFECTS_HAS_BACK_BUFFER) && defined(CONFIG_EFFECTS_FRAME_BLOCK)
+        /* Animate overlaps the flush, render must wait for a free slot. */
+        PROFILE_START(stall);
+        while (ring_full(&frames)) {
+            xEventGroupWaitBits(
+                event,
+                FLUSH_FINISHED,
+                pdTRUE,
+                pdFALSE,
+                portMAX_DELAY
+            );
         }
+        PROFILE_END(PROFILE_STALL, stall);
+#endif
+
+#ifdef CONFIG_EFFECTS_INDEXED
+        /* Previous frame has been flushed, palette can change. */
+        indexed_commit();
+#endif /* CONFIG_EFFECTS_INDEXED */
+
+        PROFILE_START(render);
+#ifdef CONFIG_EFFECTS_GOVERNOR
+        const int64_t started = esp_timer_get_time();
+#endif /* CONFIG_EFFECTS_GOVERNOR */
+        switch(effect) {
+            case 0:
+                render_frame(metaballs_render_rows);
+                break;
+            case 1:
+                render_frame(plasma_render_rows);
+                break;
+            case 2:
+                render_frame(rotozoom_render_rows);
+                break;
+            case 3:
+                render_frame(deform_render_rows);
+                break;
+            case 4:
+                render_frame(sineplasma_render_rows);
+                break;
+        }
+        PROFILE_END(PROFILE_RENDER, render);
+#ifdef CONFIG_EFFECTS_GOVERNOR
+        govern(esp_timer_get_time() - started);
+#endif /* CONFIG_EFFECTS_GOVERNOR */
+
+        render_hud();
+
+#ifdef EFFECTS_HAS_BACK_BUFFER
+        frame_t frame = { .number = number++ };
+#ifdef CONFIG_EFFECTS_FRAME_DROP
+        /*
+         * Previous frame still being flushed, this one is dropped. Flush
+         * task sees the gap in frame numbers.
+         */
+        ring_push(&frames, &frame);
+#else
+        /* Cannot fail, a free slot was waited for above. */
+        if (!ring_push(&frames, &frame)) {
+            ESP_LOGE(TAG, "No free slot for frame %lu", frame.number);
+        }
+#endif /* CONFIG_EFFECTS_FRAME_DROP */
+
         /* Notify flush task that rendering has finished. */
         xEventGroupSetBits(event, RENDER_FINISHED);
-
+#else
+        if (atomic_load(&switching)) {
+            atomic_store(&switching, false);
+            xEventGroupSetBits(event, EFFECT_SWITCHED);
+        }
+        number++;
+#endif /* EFFECTS_HAS_BACK_BUFFER */
     }
 
     vTaskDelete(NULL);
@@ -281,26 +633,119 @@ app_main()
     event = xEventGroupCreate();
 
     display = hagl_init();
+
+#ifdef CONFIG_EFFECTS_DIRTY_ROWS
+    /* Flush only rows which changed since the previous frame. */
+    hagl_backend_t *tracked = dirty_init(display);
+    if (tracked) {
+        display = tracked;
+    } else {
+        ESP_LOGE(TAG, "No memory for back buffer, drawing directly to display");
+    }
+#endif /* CONFIG_EFFECTS_DIRTY_ROWS */
+
     fps_init(&fps);
     aps_init(&bps);
 
-    /* Reserve 20 pixels in top and bottom for debug texts. */
-    hagl_set_clip(display, 0, 20, DISPLAY_WIDTH - 1, DISPLAY_HEIGHT - 21);
+    /* Reserve bands in top and bottom for debug texts. */
+    hagl_set_clip(display, 0, HUD_HEIGHT, DISPLAY_WIDTH - 1, DISPLAY_HEIGHT - HUD_HEIGHT - 1);
+
+#ifdef CONFIG_EFFECTS_INDEXED
+    /* Eight bit back buffer, effect palette covers the clip window. */
+    hagl_backend_t *indexed = indexed_init(display);
+    if (indexed) {
+        display = indexed;
+    } else {
+        ESP_LOGE(TAG, "No memory for back buffer, drawing directly to display");
+    }
+#endif /* CONFIG_EFFECTS_INDEXED */
+
+    /* Texts use the colors of the final backend. */
+    if (!hud_init(display, font6x9)) {
+        ESP_LOGE(TAG, "No memory for texts");
+    }
+
+    /* Textures use the colors of the final backend too. */
+#ifdef CONFIG_EFFECTS_TILED_TEXTURES
+    const uint8_t layout = ASSET_TILED;
+#else
+    const uint8_t layout = ASSET_LINEAR;
+#endif /* CONFIG_EFFECTS_TILED_TEXTURES */
+    if (!asset_init(display, layout)) {
+        ESP_LOGW(TAG, "No memory for textures, reading them from flash");
+    }
+
+#ifdef CONFIG_EFFECTS_STRIPS
+    /* Strips cover the clip window, set it first. */
+    strips = strip_init(display, CONFIG_EFFECTS_STRIP_LINES);
+    if (strips) {
+        ring_init(&frames, STRIP_SLOTS);
+        ESP_LOGI(TAG, "Rendering in %d strips of %d lines", strip_count(), CONFIG_EFFECTS_STRIP_LINES);
+        xTaskCreatePinnedToCore(strip_task, "Strip", 4096, NULL, 1, NULL, 0);
+    } else {
+        ESP_LOGE(TAG, "No memory for strips, drawing directly to display");
+    }
+#endif /* CONFIG_EFFECTS_STRIPS */
 
     ESP_LOGI(TAG, "Heap after HAGL init: %ld", esp_get_free_heap_size());
 
-#ifdef HAGL_HAS_HAL_BACK_BUFFER
+    /*
+     * One arena shared by all effects. Current and next effect live
+     * in it at the same time, size it for the largest such pair.
+     */
+    const size_t sizes[5] = {
+        0,
+        plasma_arena_size(),
+        rotozoom_arena_size(),
+        deform_arena_size(),
+        sineplasma_arena_size(),
+    };
+    size_t size = 0;
+    for (uint8_t i = 0; i < 5; i++) {
+        const size_t pair = sizes[i] + sizes[(i + 1) % 5];
+        if (pair > size) {
+            size = pair;
+        }
+    }
+    if (!arena_init(size)) {
+        ESP_LOGE(TAG, "Could not reserve %u bytes for effects", size);
+    }
+    ESP_LOGI(TAG, "Heap after reserving %u bytes for effects: %ld", size, esp_get_free_heap_size());
+
+    /* Tables are generated on first boot and read from flash after. */
+    if (!cache_init("lutcache")) {
+        ESP_LOGW(TAG, "No lutcache partition, generating tables on every boot");
+    }
+
+#ifdef CONFIG_EFFECTS_GOVERNOR
+    /* Start from the configured pixel size. */
+    governor_init(&governors[0], CONFIG_EFFECTS_GOVERNOR_FPS, CONFIG_EFFECTS_METABALLS_PIXEL_SIZE);
+    metaballs_scale(governors[0].scale);
+    governor_init(&governors[2], CONFIG_EFFECTS_GOVERNOR_FPS, CONFIG_EFFECTS_ROTOZOOM_PIXEL_SIZE);
+    rotozoom_scale(governors[2].scale);
+    ESP_LOGI(TAG, "Adapting pixel size to %d fps", CONFIG_EFFECTS_GOVERNOR_FPS);
+#endif /* CONFIG_EFFECTS_GOVERNOR */
+
+    effect_init(effect);
+
+#ifdef EFFECTS_HAS_BACK_BUFFER
+    /* HAL owns the only back buffer, one frame can wait for flush. */
+    ring_init(&frames, 1);
     xTaskCreatePinnedToCore(flush_task, "Flush", 4096, NULL, 1, NULL, 0);
 #endif
 
 #ifdef CONFIG_IDF_TARGET_ESP32S2
     /* ESP32-S2 has only one core, run everthing in core 0. */
     xTaskCreatePinnedToCore(demo_task, "Demo", 8092, NULL, 1, NULL, 0);
-    xTaskCreatePinnedToCore(switch_task, "Switch", 3072, NULL, 2, NULL, 0);
+    /* Same priority as demo so that preparing the next effect shares the core. */
+    xTaskCreatePinnedToCore(switch_task, "Switch", SWITCH_STACK, NULL, 1, NULL, 0);
     xTaskCreatePinnedToCore(stats_task, "Stats", 3072, NULL, 2, NULL, 0);
 #else
+    /* Core 0 helps with rendering when not flushing. */
+    parallel_init(0);
     xTaskCreatePinnedToCore(demo_task, "Demo", 8092, NULL, 1, NULL, 1);
-    xTaskCreatePinnedToCore(switch_task, "Switch", 3072, NULL, 2, NULL, 1);
+    /* Next effect is prepared on core 0 while it is not rendering or flushing. */
+    xTaskCreatePinnedToCore(switch_task, "Switch", SWITCH_STACK, NULL, 1, NULL, 0);
     xTaskCreatePinnedToCore(stats_task, "Stats", 3072, NULL, 2, NULL, 1);
 #endif /* CONFIG_IDF_TARGET_ESP32S2 */
 }
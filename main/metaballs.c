@@ -25,44 +25,106 @@ SPDX-License-Identifier: MIT-0
 
 */
 
+#include "sdkconfig.h"
+
 #include <stdint.h>
 #include <stdlib.h>
 #include <hagl.h>
 
 #include "metaballs.h"
+#include "span.h"
+#include "kernel.h"
+
+/*
+ * Field is evaluated in 16.16 fixed point. Each ball contributes
+ * radius^2 / distance^2. Division is replaced with a table of
+ * reciprocals for the rounded 1.8 bit mantissa of distance^2, which
+ * keeps the relative error below 0.2%.
+ */
+#define FIELD_SHIFT     (16)
+#define FIELD(value)    ((uint32_t) ((value) * (1 << FIELD_SHIFT)))
 
-struct vector2 {
-    int16_t x;
-    int16_t y;
-};
+/*
+ * Field is evaluated in tiles of 8 x 8 blocks. Balls which cannot reach
+ * a tile are skipped and tiles where the field stays within one color
+ * band are filled without evaluating the field at all.
+ */
+#define TILE_BLOCKS     (8)
+#define MAX_TILES       (DISPLAY_WIDTH / TILE_BLOCKS + 1)
 
-struct ball {
-    struct vector2 position;
-    struct vector2 velocity;
-    uint16_t radius;
-    uint16_t color;
-};
+/* Radius must stay below 64 so that sum of 16 balls fits in 32 bits. */
+#define MAX_BALLS       (16)
 
-struct ball balls[16];
+/* A define so that the ball loops have a constant trip count. */
+#define NUM_BALLS       (CONFIG_EFFECTS_METABALLS_BALLS)
+
+/* Ball data is stored as structure of arrays for the inner loop. */
+static int16_t ball_x[NUM_BALLS];
+static int16_t ball_y[NUM_BALLS];
+static int16_t velocity_x[NUM_BALLS];
+static int16_t velocity_y[NUM_BALLS];
+static uint32_t radius2[NUM_BALLS];
+
+static uint32_t reciprocal[257];
 
-static const uint8_t NUM_BALLS = 3;
 static const uint8_t MIN_VELOCITY = 3;
 static const uint8_t MAX_VELOCITY = 5;
-static const uint8_t MIN_RADIUS = 22;
-static const uint8_t MAX_RADIUS = 32;
-static const uint8_t PIXEL_SIZE = 2;
+static const uint8_t MIN_RADIUS = CONFIG_EFFECTS_METABALLS_MIN_RADIUS;
+static const uint8_t MAX_RADIUS = CONFIG_EFFECTS_METABALLS_MAX_RADIUS;
+#ifdef CONFIG_EFFECTS_GOVERNOR
+static uint8_t pixel_size = CONFIG_EFFECTS_METABALLS_PIXEL_SIZE;
+#else
+static const uint8_t pixel_size = CONFIG_EFFECTS_METABALLS_PIXEL_SIZE;
+#endif /* CONFIG_EFFECTS_GOVERNOR */
+
+static const uint32_t THRESHOLD_BLACK = FIELD(0.65);
+static const uint32_t THRESHOLD_WHITE = FIELD(0.5);
+static const uint32_t THRESHOLD_GREEN = FIELD(0.4);
+
+/*
+ * Balls contributing less than this to a whole tile are ignored there.
+ * This is an approximation. Together the ignored balls add less than
+ * 1/64 of the lowest threshold, so a pixel changes color only where the
+ * field is already that close to a threshold.
+ */
+static const uint32_t THRESHOLD_CULL = FIELD(0.4 / (64 * NUM_BALLS));
+
+/*
+ * Returns radius^2 / distance^2 in 16.16 fixed point. Result never
+ * increases with distance so it can also be used as an upper bound.
+ */
+static inline uint32_t
+falloff(uint32_t r2, uint32_t d2)
+{
+    if (0 == d2) {
+        return UINT32_MAX / MAX_BALLS;
+    }
+
+    /* Normalize distance^2 to 1.8 fixed point mantissa and exponent. */
+    const uint8_t exponent = 31 - __builtin_clz(d2);
+    const uint32_t mantissa = exponent > 8
+        ? (d2 + (1 << (exponent - 9))) >> (exponent - 8)
+        : d2 << (8 - exponent);
+
+    return (r2 * reciprocal[mantissa - 256]) >> exponent;
+}
 
 void
 metaballs_init()
 {
+    /* 2^24 / mantissa for mantissas 1.0 ... 2.0 */
+    for (uint16_t i = 0; i < 257; i++) {
+        reciprocal[i] = ((1 << 24) + (256 + i) / 2) / (256 + i);
+    }
+
     /* Set up imaginary balls inside screen coordinates. */
     for (int16_t i = 0; i < NUM_BALLS; i++) {
-        balls[i].radius = (rand() % MAX_RADIUS) + MIN_RADIUS;
-        balls[i].color = 0xffff;
-        balls[i].position.x = rand() % DISPLAY_WIDTH;
-        balls[i].position.y = rand() % DISPLAY_HEIGHT;
-        balls[i].velocity.x = (rand() % MAX_VELOCITY) + MIN_VELOCITY;
-        balls[i].velocity.y = (rand() % MAX_VELOCITY) + MIN_VELOCITY;
+        const uint16_t radius = (rand() % MAX_RADIUS) + MIN_RADIUS;
+        radius2[i] = radius * radius;
+        ball_x[i] = rand() % DISPLAY_WIDTH;
+        ball_y[i] = rand() % DISPLAY_HEIGHT;
+        velocity_x[i] = (rand() % MAX_VELOCITY) + MIN_VELOCITY;
+        velocity_y[i] = (rand() % MAX_VELOCITY) + MIN_VELOCITY;
     }
 }
 
@@ -70,57 +132,154 @@ void
 metaballs_animate()
 {
     for (int16_t i = 0; i < NUM_BALLS; i++) {
-        balls[i].position.x += balls[i].velocity.x;
-        balls[i].position.y += balls[i].velocity.y;
+        ball_x[i] += velocity_x[i];
+        ball_y[i] += velocity_y[i];
 
         /* Touch left or right edge, change direction. */
-        if ((balls[i].position.x < 0) | (balls[i].position.x > DISPLAY_WIDTH)) {
-            balls[i].velocity.x = balls[i].velocity.x * -1;
+        if ((ball_x[i] < 0) | (ball_x[i] > DISPLAY_WIDTH)) {
+            velocity_x[i] = velocity_x[i] * -1;
         }
 
         /* Touch top or bottom edge, change direction. */
-        if ((balls[i].position.y < 0) | (balls[i].position.y > DISPLAY_HEIGHT)) {
-            balls[i].velocity.y = balls[i].velocity.y * -1;
+        if ((ball_y[i] < 0) | (ball_y[i] > DISPLAY_HEIGHT)) {
+            velocity_y[i] = velocity_y[i] * -1;
         }
     }
 }
 
+/* Distance from value to the closest point in range min ... max. */
+static inline int32_t
+closest(int32_t value, int32_t min, int32_t max)
+{
+    if (value < min) {
+        return min - value;
+    }
+    if (value > max) {
+        return value - max;
+    }
+    return 0;
+}
+
+/* Distance from value to the farthest point in range min ... max. */
+static inline int32_t
+farthest(int32_t value, int32_t min, int32_t max)
+{
+    return abs(value - min) > abs(value - max) ? abs(value - min) : abs(value - max);
+}
+
+/* Which of the four color bands the field value falls into. */
+static inline uint8_t
+level(uint32_t sum)
+{
+    return (sum > THRESHOLD_GREEN) + (sum > THRESHOLD_WHITE) + (sum > THRESHOLD_BLACK);
+}
+
 /* http://www.geisswerks.com/ryan/BLOBS/blobs.html */
 void
-metaballs_render(hagl_backend_t const *display)
+metaballs_render_rows(hagl_backend_t const *display, int16_t y0, int16_t y1)
 {
     const hagl_color_t background = hagl_color(display, 0, 0, 0);
     const hagl_color_t black = hagl_color(display, 0, 0, 0);
     const hagl_color_t white = hagl_color(display, 255, 255, 255);
     const hagl_color_t green = hagl_color(display, 0, 255, 0);
-    hagl_color_t color;
+    const hagl_color_t colors[4] = { background, green, white, black };
+    hagl_color_t row[DISPLAY_WIDTH] KERNEL_ALIGNED;
+
+    const uint16_t tile_size = TILE_BLOCKS * pixel_size;
+    const uint8_t tiles = (DISPLAY_WIDTH + tile_size - 1) / tile_size;
+
+    /* Indexes of balls which can affect each tile in the current band. */
+    uint8_t active[MAX_TILES][NUM_BALLS];
+    uint8_t count[MAX_TILES];
+    hagl_color_t fill[MAX_TILES];
+    int32_t dy2[NUM_BALLS];
+
+    for (uint16_t band = SPAN_ALIGN(y0, pixel_size); band < y1; band += tile_size) {
+        /* Pixels are sampled at the top left corner of each block. */
+        const int32_t top = band;
+        const int32_t bottom = band + tile_size - pixel_size;
+
+        for (uint8_t tile = 0; tile < tiles; tile++) {
+            const int32_t x0 = tile * tile_size;
+            const int32_t x1 = x0 + tile_size - pixel_size;
+            uint32_t high = 0;
+            uint32_t low = 0;
 
-    for (uint16_t y = 0; y < DISPLAY_HEIGHT; y += PIXEL_SIZE) {
-        for (uint16_t x = 0; x < DISPLAY_WIDTH; x += PIXEL_SIZE) {
-            float sum = 0;
+            count[tile] = 0;
             for (uint8_t i = 0; i < NUM_BALLS; i++) {
-                const float dx = x - balls[i].position.x;
-                const float dy = y - balls[i].position.y;
-                const float d2 = dx * dx + dy * dy;
-                sum += balls[i].radius * balls[i].radius / d2;
-                // sum += balls[i].radius / sqrt(d2);
+                int32_t dx = closest(ball_x[i], x0, x1);
+                int32_t dy = closest(ball_y[i], top, bottom);
+                const uint32_t strongest = falloff(radius2[i], dx * dx + dy * dy);
+
+                dx = farthest(ball_x[i], x0, x1);
+                dy = farthest(ball_y[i], top, bottom);
+                low += falloff(radius2[i], dx * dx + dy * dy);
+                high += strongest;
+
+                if (strongest >= THRESHOLD_CULL) {
+                    active[tile][count[tile]++] = i;
+                }
             }
 
-            if (sum > 0.65) {
-                color = black;
-            } else if (sum > 0.5) {
-                color = white;
-            } else if (sum > 0.4) {
-                color = green;
-            } else {
-                color = background;
+            /* Field stays within one color band, whole tile is single color. */
+            if (level(low) == level(high)) {
+                fill[tile] = colors[level(low)];
+                count[tile] = 0;
+            } else if (0 == count[tile]) {
+                fill[tile] = background;
             }
+        }
+
+        for (uint16_t y = band; y < band + tile_size && y < y1; y += pixel_size) {
+            hagl_color_t *ptr = row;
 
-            if (1 == PIXEL_SIZE) {
-                hagl_put_pixel(display, x, y, color);
-            } else {
-                hagl_fill_rectangle(display, x, y, x + PIXEL_SIZE - 1, y + PIXEL_SIZE - 1, color);
+            for (uint8_t i = 0; i < NUM_BALLS; i++) {
+                const int32_t dy = y - ball_y[i];
+                dy2[i] = dy * dy;
             }
+
+            for (uint8_t tile = 0; tile < tiles; tile++) {
+                const uint16_t x0 = tile * tile_size;
+                const uint16_t x1 = x0 + tile_size < DISPLAY_WIDTH ? x0 + tile_size : DISPLAY_WIDTH;
+                const uint8_t *balls = active[tile];
+
+                /* Field is known for the whole tile, skip evaluation. */
+                if (0 == count[tile]) {
+                    const uint16_t blocks = (x1 - x0 + pixel_size - 1) / pixel_size;
+                    kernel_fill16(ptr, fill[tile], blocks);
+                    ptr += blocks;
+                    continue;
+                }
+
+                for (uint16_t x = x0; x < x1; x += pixel_size) {
+                    uint32_t sum = 0;
+
+                    for (uint8_t j = 0; j < count[tile]; j++) {
+                        const uint8_t i = balls[j];
+                        const int32_t dx = x - ball_x[i];
+                        sum += falloff(radius2[i], dx * dx + dy2[i]);
+                    }
+
+                    *(ptr++) = colors[level(sum)];
+                }
+            }
+            /* Put the whole row to the display. */
+            span_put_row(display, y, row, pixel_size);
         }
     }
 }
+
+void
+metaballs_render(hagl_backend_t const *display)
+{
+    metaballs_render_rows(display, SPAN_TOP(display), display->clip.y1 + 1);
+}
+
+#ifdef CONFIG_EFFECTS_GOVERNOR
+void
+metaballs_scale(uint8_t size)
+{
+    /* Takes effect from the next render. */
+    pixel_size = size;
+}
+#endif /* CONFIG_EFFECTS_GOVERNOR */
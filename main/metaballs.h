@@ -27,4 +27,11 @@ SPDX-License-Identifier: MIT-0
 
 void metaballs_init();
 void metaballs_animate();
-void metaballs_render(hagl_backend_t const *surface);
\ No newline at end of file
+void metaballs_render(hagl_backend_t const *surface);
+void metaballs_render_rows(hagl_backend_t const *surface, int16_t y0, int16_t y1);
+
+/*
+ * Change pixel size at runtime. Call between frames. Only available
+ * with CONFIG_EFFECTS_GOVERNOR, otherwise pixel size is a constant.
+ */
+void metaballs_scale(uint8_t size);
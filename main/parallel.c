@@ -0,0 +1,121 @@
+/*
+
+MIT No Attribution
+
+Copyright (c) 2023 Mika Tuupola
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+-cut-
+
+Splits rendering of a frame between both cores. The work queue is a
+single atomic band counter, whichever core is free takes the next
+band.
+
+SPDX-License-Identifier: MIT-0
+
+*/
+
+#include "sdkconfig.h"
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_log.h>
+#include <hagl.h>
+
+#include "parallel.h"
+#include "span.h"
+
+#ifndef CONFIG_FREERTOS_UNICORE
+
+static const char *TAG = "parallel";
+
+static hagl_backend_t const *surface;
+static render_rows_t *job;
+static int16_t top;
+static int16_t bottom;
+static uint32_t bands;
+static atomic_uint next;
+static TaskHandle_t helper;
+static TaskHandle_t caller;
+
+/* Render bands until there are none left. */
+static void
+work()
+{
+    uint32_t band;
+
+    while ((band = atomic_fetch_add(&next, 1)) < bands) {
+        const int16_t y0 = top + band * PARALLEL_BAND_HEIGHT;
+        const int16_t y1 = y0 + PARALLEL_BAND_HEIGHT < bottom ? y0 + PARALLEL_BAND_HEIGHT : bottom;
+        job(surface, y0, y1);
+    }
+}
+
+static void
+helper_task(void *params)
+{
+    while (1) {
+        /* Wait for the next frame. */
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        work();
+        /* Tell caller this core is done. */
+        xTaskNotifyGive(caller);
+    }
+
+    vTaskDelete(NULL);
+}
+
+#endif /* CONFIG_FREERTOS_UNICORE */
+
+void
+parallel_init(uint8_t core)
+{
+#ifndef CONFIG_FREERTOS_UNICORE
+    atomic_init(&next, PARALLEL_BANDS);
+    /* Above flush task so that bands are not time sliced with it. */
+    xTaskCreatePinnedToCore(helper_task, "Helper", 8092, NULL, 2, &helper, core);
+    ESP_LOGI(TAG, "Rendering up to %d bands on two cores", PARALLEL_BANDS);
+#endif /* CONFIG_FREERTOS_UNICORE */
+}
+
+void
+parallel_render(hagl_backend_t const *display, render_rows_t *render)
+{
+#ifdef CONFIG_FREERTOS_UNICORE
+    render(display, SPAN_TOP(display), display->clip.y1 + 1);
+#else
+    surface = display;
+    job = render;
+
+    /* Only rows inside the clip window, texts are drawn above and below. */
+    top = SPAN_TOP(display);
+    bottom = display->clip.y1 + 1;
+    bands = (bottom - top + PARALLEL_BAND_HEIGHT - 1) / PARALLEL_BAND_HEIGHT;
+    caller = xTaskGetCurrentTaskHandle();
+
+    /* Publish the job, then wake up the helper. */
+    atomic_store(&next, 0);
+    xTaskNotifyGive(helper);
+
+    work();
+
+    /* Bands may still be in progress on the other core. */
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+#endif /* CONFIG_FREERTOS_UNICORE */
+}
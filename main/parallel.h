@@ -0,0 +1,56 @@
+/*
+
+MIT No Attribution
+
+Copyright (c) 2023 Mika Tuupola
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+-cut-
+
+SPDX-License-Identifier: MIT-0
+
+*/
+
+#ifndef _PARALLEL_H
+#define _PARALLEL_H
+
+#include <stdint.h>
+#include <hagl.h>
+
+/* Height of one unit of work in pixels. */
+#define PARALLEL_BAND_HEIGHT    (16)
+#define PARALLEL_BANDS          ((DISPLAY_HEIGHT + PARALLEL_BAND_HEIGHT - 1) / PARALLEL_BAND_HEIGHT)
+
+/* Renders rows y0 ... y1 - 1 of the current frame. */
+typedef void render_rows_t(hagl_backend_t const *display, int16_t y0, int16_t y1);
+
+/*
+ * Start a helper task on the other core. On single core targets this
+ * does nothing and frames are rendered by the calling task alone.
+ */
+void parallel_init(uint8_t core);
+
+/*
+ * Render the clip window of one frame split into horizontal bands,
+ * starting from SPAN_TOP(display). Calling task and the helper task
+ * both pull bands from a shared counter until all bands are done, so
+ * slow bands balance out. Returns when the whole frame has been
+ * rendered.
+ */
+void parallel_render(hagl_backend_t const *display, render_rows_t *render);
+
+#endif /* _PARALLEL_H */
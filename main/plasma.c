@@ -25,86 +25,152 @@ SPDX-License-Identifier: MIT-0
 
 */
 
+#include "sdkconfig.h"
+
+#include <stdbool.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <math.h>
 #include <hagl.h>
 
 #include "plasma.h"
+#include "span.h"
+#include "arena.h"
+#include "cache.h"
+#include "kernel.h"
+#include "indexed.h"
+#include "fixed.h"
 
 hagl_color_t *palette;
 uint8_t *plasma;
 
-static const uint8_t SPEED = 4;
-static const uint8_t PIXEL_SIZE = 2;
+/* Animation rotates the palette instead of touching the plasma buffer. */
+static uint8_t offset;
+
+/*
+ * With an indexed back buffer plasma indices are written as is and the
+ * back buffer rotates the palette. Only the first frame is rendered.
+ */
+static bool indices;
+static uint32_t frames;
+
+static const uint8_t SPEED = CONFIG_EFFECTS_PLASMA_SPEED;
+static const uint8_t PIXEL_SIZE = CONFIG_EFFECTS_PLASMA_PIXEL_SIZE;
+#ifdef CONFIG_EFFECTS_PLASMA_BILINEAR
+static const uint8_t FILTER = SPAN_BILINEAR;
+#else
+static const uint8_t FILTER = SPAN_NEAREST;
+#endif
+
+/* Bump when the generated tables change. */
+static const uint32_t VERSION = 1 + FIXED_VERSION;
+
+/* One index per PIXEL_SIZE x PIXEL_SIZE block. */
+#define PLASMA_SIZE (SPAN_WIDTH(PIXEL_SIZE) * ((DISPLAY_HEIGHT + PIXEL_SIZE - 1) / PIXEL_SIZE))
+
+size_t
+plasma_arena_size()
+{
+    return ARENA_SIZE(PLASMA_SIZE * sizeof(uint8_t)) + ARENA_SIZE(256 * sizeof(hagl_color_t));
+}
 
 void
 plasma_init(hagl_backend_t const *display)
 {
-    uint8_t *ptr = plasma = malloc(DISPLAY_WIDTH * DISPLAY_HEIGHT * sizeof(uint8_t));
-    palette = malloc(256 * sizeof(hagl_color_t));
+    const cache_key_t plasma_key = { "plasma", PIXEL_SIZE, VERSION };
+
+    uint8_t *ptr = plasma = arena_alloc(PLASMA_SIZE * sizeof(uint8_t));
+    palette = arena_alloc(256 * sizeof(hagl_color_t));
+    offset = 0;
+    frames = 0;
+
+    /* Palette is always in HAL colors, also when writing indices. */
+    hagl_backend_t const *hal = indexed_target(display);
+    indices = NULL != hal;
+    if (!indices) {
+        hal = display;
+    }
 
     /* Generate nice continous palette. */
     for(uint16_t i = 0; i < 256; i++) {
+#ifdef CONFIG_EFFECTS_FIXED_POINT
+        const uint8_t r = 128 + ((128 * fixed_sin(i * FIXED_TURN / 256 + fixed_radians(1, 0))) >> FIXED_SINE_SHIFT);
+        const uint8_t g = 128 + ((128 * fixed_sin(i * FIXED_TURN / 128 + fixed_radians(1, 0))) >> FIXED_SINE_SHIFT);
+#else
         const uint8_t r = 128.0f + 128.0f * sin((M_PI * i / 128.0f) + 1);
         const uint8_t g = 128.0f + 128.0f * sin((M_PI * i / 64.0f) + 1);
+#endif /* CONFIG_EFFECTS_FIXED_POINT */
         const uint8_t b = 64;
-        palette[i] = hagl_color(display, r, g, b);
+        palette[i] = hagl_color(hal, r, g, b);
+    }
+
+    if (cache_load(&plasma_key, plasma, PLASMA_SIZE * sizeof(uint8_t))) {
+        return;
     }
 
     for (uint16_t y = 0; y < DISPLAY_HEIGHT; y += PIXEL_SIZE) {
         for (uint16_t x = 0; x < DISPLAY_WIDTH; x += PIXEL_SIZE) {
             /* Generate three different sinusoids. */
+#ifdef CONFIG_EFFECTS_FIXED_POINT
+            /* Radius in Q6 is precise enough for the color index. */
+            const int32_t radius = fixed_isqrt((uint32_t) (x * x + y * y) << 12);
+            const int32_t v1 = (128 << FIXED_SINE_SHIFT) + 128 * fixed_sin(fixed_radians(x, 5));
+            const int32_t v2 = (128 << FIXED_SINE_SHIFT) + 128 * fixed_sin(fixed_radians((y << 16) / 24, 16));
+            const int32_t v3 = (128 << FIXED_SINE_SHIFT) + 128 * fixed_sin(fixed_radians((radius << 10) / 24, 16));
+            /* Calculate average of the three sinusoids */
+            /* and use it as color index. */
+            const uint8_t color = (v1 + v2 + v3) / (3 << FIXED_SINE_SHIFT);
+#else
             const float v1 = 128.0f + (128.0f * sin(x / 32.0f));
             const float v2 = 128.0f + (128.0f * sin(y / 24.0f));
             const float v3 = 128.0f + (128.0f * sin(sqrt(x * x + y * y) / 24.0f));
             /* Calculate average of the three sinusoids */
             /* and use it as color index. */
             const uint8_t color = (v1 + v2 + v3) / 3;
+#endif /* CONFIG_EFFECTS_FIXED_POINT */
             *(ptr++) = color;
         }
     }
+
+    cache_store(&plasma_key, plasma, PLASMA_SIZE * sizeof(uint8_t));
 }
 
-void
-plasma_render(hagl_backend_t const *display)
+static void
+plasma_row(hagl_color_t *colors, uint16_t row)
 {
-    uint8_t *ptr = plasma;
-
-    for (uint16_t y = 0; y < DISPLAY_HEIGHT; y += PIXEL_SIZE) {
-        for (uint16_t x = 0; x < DISPLAY_WIDTH; x += PIXEL_SIZE) {
-            /* Get a color for pixel from the plasma buffer. */
-            const uint8_t index = *(ptr++);
-            const hagl_color_t color = palette[index];
-            /* Put a pixel to the display. */
-            if (1 == PIXEL_SIZE) {
-                hagl_put_pixel(display, x, y, color);
-            } else {
-                hagl_fill_rectangle(display, x, y, x + PIXEL_SIZE - 1, y + PIXEL_SIZE - 1, color);
-            }
-        }
+    /* Get colors for the row from the plasma buffer. */
+    const uint8_t *ptr = plasma + row * SPAN_WIDTH(PIXEL_SIZE);
+    if (indices) {
+        kernel_lookup8(colors, ptr, indexed_identity(), 0, SPAN_WIDTH(PIXEL_SIZE));
+    } else {
+        kernel_lookup8(colors, ptr, palette, offset, SPAN_WIDTH(PIXEL_SIZE));
     }
 }
 
 void
-plasma_animate()
+plasma_render_rows(hagl_backend_t const *display, int16_t y0, int16_t y1)
 {
-    uint8_t *ptr = plasma;
-
-    for (uint16_t y = 0; y < DISPLAY_HEIGHT; y = y + PIXEL_SIZE) {
-        for (uint16_t x = 0; x < DISPLAY_WIDTH; x = x + PIXEL_SIZE) {
-            /* Get a color from plasma and choose the next color. */
-            /* Unsigned integers wrap automatically. */
-            const uint8_t index = *ptr + SPEED;
-            /* Put the new color back to the plasma buffer. */
-            *(ptr++) = index;
-        }
+    /* Indices in the back buffer do not change after the first frame. */
+    if (indices && frames > 1) {
+        return;
     }
+    span_render(display, y0, y1, plasma_row, PIXEL_SIZE, FILTER);
+}
+
+void
+plasma_render(hagl_backend_t const *display)
+{
+    plasma_render_rows(display, SPAN_TOP(display), display->clip.y1 + 1);
 }
 
 void
-plasma_close()
+plasma_animate()
 {
-    free(plasma);
-    free(palette);
-}
\ No newline at end of file
+    /* Same as adding SPEED to every index in the plasma buffer. */
+    offset += SPEED;
+    frames++;
+
+    if (indices) {
+        indexed_palette(palette, offset);
+    }
+}
@@ -28,4 +28,5 @@ SPDX-License-Identifier: MIT-0
 void plasma_init();
 void plasma_animate();
 void plasma_render(hagl_backend_t const *surface);
-void plasma_close();
+void plasma_render_rows(hagl_backend_t const *surface, int16_t y0, int16_t y1);
+size_t plasma_arena_size();
@@ -0,0 +1,194 @@
+/*
+
+MIT No Attribution
+
+Copyright (c) 2023 Mika Tuupola
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+-cut-
+
+Per phase frame time histograms. Buckets are log-linear, each power of
+two is split into eight sub buckets so reported percentiles are within
+12.5% of the real value. Maximum is exact.
+
+SPDX-License-Identifier: MIT-0
+
+*/
+
+#include "sdkconfig.h"
+
+#ifdef CONFIG_EFFECTS_PROFILE
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_log.h>
+
+#include "profile.h"
+
+#define SUB_BITS    (3)
+#define SUB_BUCKETS (1 << SUB_BITS)
+#define BUCKETS     ((32 - SUB_BITS + 1) * SUB_BUCKETS)
+
+typedef struct {
+    uint32_t buckets[BUCKETS];
+    uint32_t count;
+    uint32_t max;
+} histogram_t;
+
+static const char *TAG = "profile";
+static const char *PHASES[PROFILE_PHASES] = {
+    "animate",
+    "render",
+    "wait",
+    "flush",
+    "stall",
+    "hud",
+};
+
+static histogram_t histograms[PROFILE_PHASES];
+
+/* FreeRTOS run time counters when the profile was last reset. */
+static configRUN_TIME_COUNTER_TYPE idle_start[portNUM_PROCESSORS];
+static configRUN_TIME_COUNTER_TYPE total_start;
+
+/* Read run time of the idle task of each core and the total run time. */
+static void
+idle_counters(configRUN_TIME_COUNTER_TYPE *idle, configRUN_TIME_COUNTER_TYPE *total)
+{
+    const UBaseType_t size = uxTaskGetNumberOfTasks() + 2;
+    TaskStatus_t *status = malloc(size * sizeof(TaskStatus_t));
+
+    memset(idle, 0, portNUM_PROCESSORS * sizeof(configRUN_TIME_COUNTER_TYPE));
+    *total = 0;
+
+    if (NULL == status) {
+        return;
+    }
+
+    const UBaseType_t count = uxTaskGetSystemState(status, size, total);
+    for (uint8_t core = 0; core < portNUM_PROCESSORS; core++) {
+        const TaskHandle_t handle = xTaskGetIdleTaskHandleForCore(core);
+        for (UBaseType_t i = 0; i < count; i++) {
+            if (status[i].xHandle == handle) {
+                idle[core] = status[i].ulRunTimeCounter;
+            }
+        }
+    }
+
+    free(status);
+}
+
+static uint16_t
+bucket(uint32_t cycles)
+{
+    if (cycles < SUB_BUCKETS) {
+        return cycles;
+    }
+    const uint8_t msb = 31 - __builtin_clz(cycles);
+    const uint8_t sub = (cycles >> (msb - SUB_BITS)) & (SUB_BUCKETS - 1);
+    return (msb - SUB_BITS + 1) * SUB_BUCKETS + sub;
+}
+
+/* Largest value which still falls into given bucket. */
+static uint32_t
+bucket_limit(uint16_t index)
+{
+    if (index < SUB_BUCKETS) {
+        return index;
+    }
+    const uint8_t shift = index / SUB_BUCKETS - 1;
+    const uint32_t sub = index % SUB_BUCKETS;
+    return ((SUB_BUCKETS + sub + 1) << shift) - 1;
+}
+
+static uint32_t
+percentile(histogram_t const *histogram, uint8_t percent)
+{
+    uint32_t wanted = (histogram->count * percent + 99) / 100;
+    uint32_t seen = 0;
+
+    for (uint16_t i = 0; i < BUCKETS; i++) {
+        seen += histogram->buckets[i];
+        if (seen >= wanted) {
+            const uint32_t limit = bucket_limit(i);
+            return limit < histogram->max ? limit : histogram->max;
+        }
+    }
+    return histogram->max;
+}
+
+void
+profile_record(uint8_t phase, uint32_t cycles)
+{
+    histogram_t *histogram = &histograms[phase];
+
+    histogram->buckets[bucket(cycles)]++;
+    histogram->count++;
+    if (cycles > histogram->max) {
+        histogram->max = cycles;
+    }
+}
+
+void
+profile_dump(const char *name)
+{
+    const uint32_t mhz = CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ;
+
+    for (uint8_t phase = 0; phase < PROFILE_PHASES; phase++) {
+        histogram_t const *histogram = &histograms[phase];
+
+        if (0 == histogram->count) {
+            continue;
+        }
+
+        ESP_LOGI(
+            TAG, "%s %-7s p50 %6ld p95 %6ld p99 %6ld max %6ld us (%ld samples)",
+            name, PHASES[phase],
+            percentile(histogram, 50) / mhz,
+            percentile(histogram, 95) / mhz,
+            percentile(histogram, 99) / mhz,
+            histogram->max / mhz,
+            histogram->count
+        );
+    }
+
+    /* Time each core spent in its idle task is the real headroom. */
+    configRUN_TIME_COUNTER_TYPE idle[portNUM_PROCESSORS];
+    configRUN_TIME_COUNTER_TYPE total;
+
+    idle_counters(idle, &total);
+    total -= total_start;
+
+    for (uint8_t core = 0; core < portNUM_PROCESSORS && total > 0; core++) {
+        ESP_LOGI(
+            TAG, "%s idle    core %d %3ld%%",
+            name, core, (uint32_t) ((uint64_t) (idle[core] - idle_start[core]) * 100 / total)
+        );
+    }
+}
+
+void
+profile_reset()
+{
+    memset(histograms, 0, sizeof(histograms));
+    idle_counters(idle_start, &total_start);
+}
+
+#endif /* CONFIG_EFFECTS_PROFILE */
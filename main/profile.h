@@ -0,0 +1,73 @@
+/*
+
+MIT No Attribution
+
+Copyright (c) 2023 Mika Tuupola
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+-cut-
+
+SPDX-License-Identifier: MIT-0
+
+*/
+
+#ifndef _PROFILE_H
+#define _PROFILE_H
+
+#include "sdkconfig.h"
+
+#include <stdint.h>
+
+enum {
+    PROFILE_ANIMATE = 0,
+    PROFILE_RENDER,
+    PROFILE_WAIT,
+    PROFILE_FLUSH,
+    PROFILE_STALL,
+    PROFILE_HUD,
+    PROFILE_PHASES
+};
+
+#ifdef CONFIG_EFFECTS_PROFILE
+
+#include <esp_cpu.h>
+
+/*
+ * Cycle counter is per core. Start and end of a phase must be taken
+ * in the same task, all tasks are pinned so this holds.
+ */
+#define PROFILE_START(start) uint32_t start = esp_cpu_get_cycle_count()
+#define PROFILE_RESTART(start) start = esp_cpu_get_cycle_count()
+#define PROFILE_END(phase, start) profile_record((phase), esp_cpu_get_cycle_count() - (start))
+#define PROFILE_DUMP(name) profile_dump(name)
+#define PROFILE_RESET() profile_reset()
+
+void profile_record(uint8_t phase, uint32_t cycles);
+void profile_dump(const char *name);
+void profile_reset();
+
+#else
+
+#define PROFILE_START(start)
+#define PROFILE_RESTART(start)
+#define PROFILE_END(phase, start)
+#define PROFILE_DUMP(name)
+#define PROFILE_RESET()
+
+#endif /* CONFIG_EFFECTS_PROFILE */
+
+#endif /* _PROFILE_H */
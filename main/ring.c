@@ -0,0 +1,96 @@
+/*
+
+MIT No Attribution
+
+Copyright (c) 2020-2023 Mika Tuupola
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+-cut-
+
+Lock free ring of frames between the render and flush tasks. There
+are no pixels in the ring, the HAL owns the buffers. A slot stands for
+a frame which has been rendered but not yet flushed, so the number of
+slots is how far rendering may run ahead of flushing. Frames get one
+slot since the HAL has one back buffer, strips one per strip buffer.
+
+SPDX-License-Identifier: MIT-0
+
+*/
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#include "ring.h"
+
+void
+ring_init(ring_t *ring, uint8_t size)
+{
+    ring->size = size < RING_MAX_SLOTS ? size : RING_MAX_SLOTS;
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+}
+
+bool
+ring_full(ring_t *ring)
+{
+    const uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    const uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    return head - tail >= ring->size;
+}
+
+bool
+ring_empty(ring_t *ring)
+{
+    const uint32_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    const uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    return head == tail;
+}
+
+bool
+ring_push(ring_t *ring, frame_t const *frame)
+{
+    const uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+
+    if (ring_full(ring)) {
+        return false;
+    }
+
+    ring->slots[head % RING_MAX_SLOTS] = *frame;
+    /* Publish the slot only after it has been written. */
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+    return true;
+}
+
+frame_t *
+ring_front(ring_t *ring)
+{
+    const uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+
+    if (ring_empty(ring)) {
+        return NULL;
+    }
+    return &ring->slots[tail % RING_MAX_SLOTS];
+}
+
+void
+ring_pop(ring_t *ring)
+{
+    const uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+}
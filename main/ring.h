@@ -0,0 +1,68 @@
+/*
+
+MIT No Attribution
+
+Copyright (c) 2020-2023 Mika Tuupola
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+-cut-
+
+SPDX-License-Identifier: MIT-0
+
+*/
+
+#ifndef _RING_H
+#define _RING_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#define RING_MAX_SLOTS  (4)
+
+typedef struct {
+    uint32_t number;
+} frame_t;
+
+/*
+ * Single producer single consumer ring of rendered frames. Head is
+ * written only by the producer and tail only by the consumer so no
+ * locks are needed. Both are free running, head - tail is the number
+ * of frames in the ring.
+ */
+typedef struct {
+    frame_t slots[RING_MAX_SLOTS];
+    uint8_t size;
+    atomic_uint head;
+    atomic_uint tail;
+} ring_t;
+
+void ring_init(ring_t *ring, uint8_t size);
+bool ring_full(ring_t *ring);
+bool ring_empty(ring_t *ring);
+
+/* Producer side. Returns false when the ring is full. */
+bool ring_push(ring_t *ring, frame_t const *frame);
+
+/*
+ * Consumer side. The front frame keeps its slot until popped so the
+ * producer cannot reuse it while the frame is being flushed.
+ */
+frame_t *ring_front(ring_t *ring);
+void ring_pop(ring_t *ring);
+
+#endif /* _RING_H */
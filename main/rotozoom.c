@@ -25,65 +25,215 @@ SPDX-License-Identifier: MIT-0
 
 */
 
+#include "sdkconfig.h"
+
+#include <stdbool.h>
 #include <stdlib.h>
 #include <math.h>
 #include <hagl.h>
 
-#include "head.h"
+#include "span.h"
+#include "arena.h"
+#include "indexed.h"
+#include "fixed.h"
+#include "asset.h"
+
+static const uint8_t SPEED = CONFIG_EFFECTS_ROTOZOOM_SPEED;
+#ifdef CONFIG_EFFECTS_GOVERNOR
+static uint8_t pixel_size = CONFIG_EFFECTS_ROTOZOOM_PIXEL_SIZE;
+#else
+static const uint8_t pixel_size = CONFIG_EFFECTS_ROTOZOOM_PIXEL_SIZE;
+#endif /* CONFIG_EFFECTS_GOVERNOR */
+#ifdef CONFIG_EFFECTS_ROTOZOOM_BILINEAR
+static const uint8_t FILTER = SPAN_BILINEAR;
+#else
+static const uint8_t FILTER = SPAN_NEAREST;
+#endif
 
-static const uint8_t SPEED = 2;
-static const uint8_t PIXEL_SIZE = 2;
+/*
+ * Texture coordinates are stepped incrementally along the row in 12.20
+ * fixed point. The largest possible coordinate is the length of the
+ * screen diagonal times the maximum zoom of 1.2.
+ */
+#define FIXED_SHIFT (20)
+#define FIXED_ONE   (1 << FIXED_SHIFT)
+#define RANGE       ((DISPLAY_WIDTH + DISPLAY_HEIGHT) * 6 / 5 + 2)
 
 static uint16_t angle;
-// static float sinlut[360];
-// static float coslut[360];
+#ifdef CONFIG_EFFECTS_FIXED_POINT
+/* Sine and cosine times zoom in Q30, row starts are multiples of these. */
+static int64_t sz, cz;
+#else
+static float s, c, z;
+#endif /* CONFIG_EFFECTS_FIXED_POINT */
+
+/* Texture coordinate change per block along the row. */
+static int32_t dudx, dvdx;
+
+/*
+ * Wrapped texture coordinates, replaces the modulo in the inner loop.
+ * Stored as offsets into the texture in its layout.
+ */
+static uint16_t uwrap[RANGE];
+static uint16_t vwrap[2 * RANGE];
+
+/* Head image, or indices to its palette with an indexed back buffer. */
+static const hagl_color_t *texture;
+static hagl_color_t *palette;
+
+size_t
+rotozoom_arena_size()
+{
+#ifdef CONFIG_EFFECTS_INDEXED
+    return ARENA_SIZE(ASSET_STRIDE(ASSET_HEAD_WIDTH) * ASSET_HEAD_HEIGHT * sizeof(hagl_color_t)) + ARENA_SIZE(256 * sizeof(hagl_color_t));
+#else
+    return 0;
+#endif /* CONFIG_EFFECTS_INDEXED */
+}
+
+void
+rotozoom_init(hagl_backend_t const *display)
+{
+    const asset_texture_t head = asset_head();
+
+    texture = head.colors;
+
+    if (indexed_target(display)) {
+        hagl_color_t *indices = arena_alloc(head.stride * ASSET_HEAD_HEIGHT * sizeof(hagl_color_t));
+        palette = arena_alloc(256 * sizeof(hagl_color_t));
+        asset_quantize(indices, palette, &head, ASSET_HEAD_HEIGHT);
+        texture = indices;
+    }
+
+    /* Horizontally texture is mirrored around zero. */
+    for (int16_t i = 0; i < RANGE; i++) {
+        uwrap[i] = asset_column(&head, i % ASSET_HEAD_WIDTH);
+    }
+
+    /* Vertically texture repeats also for negative coordinates. */
+    for (int16_t i = -RANGE; i < RANGE; i++) {
+        int16_t v = i % ASSET_HEAD_HEIGHT;
+        if (v < 0) {
+            v += ASSET_HEAD_HEIGHT;
+        }
+        vwrap[i + RANGE] = asset_row(&head, v);
+    }
+}
+
+#ifdef CONFIG_EFFECTS_FIXED_POINT
+/*
+ * Q30 to 12.20. Bias is added to the magnitude, half a unit rounds like
+ * lroundf() and a whole unit rounds away from zero.
+ */
+static inline int32_t
+round20(int64_t value, int64_t bias)
+{
+    if (value < 0) {
+        return -((-value + bias) >> (2 * FIXED_SINE_SHIFT - FIXED_SHIFT));
+    }
+    return (value + bias) >> (2 * FIXED_SINE_SHIFT - FIXED_SHIFT);
+}
+
+#define HALF    (1 << (2 * FIXED_SINE_SHIFT - FIXED_SHIFT - 1))
+#define ALMOST  ((1 << (2 * FIXED_SINE_SHIFT - FIXED_SHIFT)) - 1)
+#endif /* CONFIG_EFFECTS_FIXED_POINT */
+
+static void
+rotozoom_row(hagl_color_t *colors, uint16_t row)
+{
+    const int32_t y = row * pixel_size;
+    hagl_color_t *ptr = colors;
+
+    /* Start of each row is calculated directly so error does not accumulate. */
+#ifdef CONFIG_EFFECTS_FIXED_POINT
+    int32_t u = round20(-y * sz, HALF);
+    int32_t v = round20(y * cz, HALF);
+#else
+    int32_t u = lroundf(-y * s * z * FIXED_ONE);
+    int32_t v = lroundf(y * c * z * FIXED_ONE);
+#endif /* CONFIG_EFFECTS_FIXED_POINT */
+
+    for (uint16_t x = 0; x < DISPLAY_WIDTH; x = x + pixel_size) {
+        /* Truncate towards zero like the float to integer cast does. */
+        const int16_t tu = abs(u) >> FIXED_SHIFT;
+        const int16_t tv = v < 0 ? -(-v >> FIXED_SHIFT) : v >> FIXED_SHIFT;
+
+        /* Get a rotated pixel from the head image. */
+        *(ptr++) = texture[vwrap[tv + RANGE] + uwrap[tu]];
+
+        u += dudx;
+        v += dvdx;
+    }
+}
 
 void
-rotozoom_init()
+rotozoom_render_rows(hagl_backend_t const *display, int16_t y0, int16_t y1)
 {
-    /* Generate look up tables. */
-    // for (uint16_t i = 0; i < 360; i++) {
-    //     sinlut[i] = sin(i * M_PI / 180);
-    //     coslut[i] = cos(i * M_PI / 180);
-    // }
+    span_render(display, y0, y1, rotozoom_row, pixel_size, FILTER);
 }
 
 void
 rotozoom_render(hagl_backend_t const *display)
 {
-    float s, c, z;
+    rotozoom_render_rows(display, SPAN_TOP(display), display->clip.y1 + 1);
+}
 
+/* Zoom is 1.2 times sine of the angle, or 1.2 when only rotating. */
+static void
+turn(bool rotating)
+{
+#ifdef CONFIG_EFFECTS_FIXED_POINT
+    const int32_t s = fixed_sin(FIXED_DEGREES(angle));
+    const int32_t c = fixed_cos(FIXED_DEGREES(angle));
+    const int32_t zoom = rotating ? FIXED_SINE_ONE : s;
+    /* Kept in Q30 and rounded only when used. */
+    sz = (int64_t) s * zoom * 6 / 5;
+    cz = (int64_t) c * zoom * 6 / 5;
+
+    /*
+     * Steps round away from zero so that coordinates which should be
+     * whole numbers, such as at right angles, do not fall short of them
+     * after a few steps.
+     */
+    dudx = round20(cz * pixel_size, ALMOST);
+    dvdx = round20(sz * pixel_size, ALMOST);
+#else
     s = sin(angle * M_PI / 180);
     c = cos(angle * M_PI / 180);
-    // s = sinlut[angle];
-    // c = coslut[angle];
-    z = s * 1.2;
-
-    for (uint16_t x = 0; x < DISPLAY_WIDTH; x = x + PIXEL_SIZE) {
-        for (uint16_t y = 0; y < DISPLAY_HEIGHT; y = y + PIXEL_SIZE) {
-
-            /* Get a rotated pixel from the head image. */
-            int16_t u = (int16_t)((x * c - y * s) * z) % HEAD_WIDTH;
-            int16_t v = (int16_t)((x * s + y * c) * z) % HEAD_HEIGHT;
-
-            u = abs(u);
-            if (v < 0) {
-                v += HEAD_HEIGHT;
-            }
-            hagl_color_t *color = (hagl_color_t *) (head + HEAD_WIDTH * sizeof(hagl_color_t) * v + sizeof(hagl_color_t) * u);
-
-            if (1 == PIXEL_SIZE) {
-                hagl_put_pixel(display, x, y, *color);
-            } else {
-                hagl_fill_rectangle(display, x, y, x + PIXEL_SIZE - 1, y + PIXEL_SIZE - 1, *color);
-            }
-            // hagl_put_pixel(x, y, *color);
-        }
-    }
+    z = rotating ? 1.2 : s * 1.2;
+
+    dudx = lroundf(c * z * pixel_size * FIXED_ONE);
+    dvdx = lroundf(s * z * pixel_size * FIXED_ONE);
+#endif /* CONFIG_EFFECTS_FIXED_POINT */
 }
 
 void
 rotozoom_animate()
 {
     angle = (angle + SPEED) % 360;
+    turn(false);
+
+    if (texture != asset_head().colors) {
+        indexed_palette(palette, 0);
+    }
+}
+
+void
+rotozoom_rotate(uint16_t degrees)
+{
+    angle = degrees % 360;
+    turn(true);
+
+    if (texture != asset_head().colors) {
+        indexed_palette(palette, 0);
+    }
+}
+
+#ifdef CONFIG_EFFECTS_GOVERNOR
+void
+rotozoom_scale(uint8_t size)
+{
+    /* Takes effect from the next animate. */
+    pixel_size = size;
 }
+#endif /* CONFIG_EFFECTS_GOVERNOR */
@@ -27,4 +27,19 @@ SPDX-License-Identifier: MIT-0
 
 void rotozoom_init();
 void rotozoom_render(hagl_backend_t const *surface);
+void rotozoom_render_rows(hagl_backend_t const *surface, int16_t y0, int16_t y1);
 void rotozoom_animate();
+size_t rotozoom_arena_size();
+
+/*
+ * Change pixel size at runtime. Call between frames. Only available
+ * with CONFIG_EFFECTS_GOVERNOR, otherwise pixel size is a constant.
+ */
+void rotozoom_scale(uint8_t size);
+
+/*
+ * Rotate to given angle with the zoom held at its largest instead of
+ * following the angle. Used to measure the cost of sampling the
+ * texture at every angle. Next animate continues from this angle.
+ */
+void rotozoom_rotate(uint16_t degrees);
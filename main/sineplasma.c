@@ -0,0 +1,189 @@
+/*
+
+MIT No Attribution
+
+Copyright (c) 2020-2023 Mika Tuupola
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+-cut-
+
+Classic demo plasma where three sine layers move independently every
+frame. Two layers depend only on x or y and are summed into column and
+row tables once per frame. The third is a radial layer read through a
+moving window of a precomputed distance table. Per pixel this leaves
+three table reads, two adds and a palette lookup, no floating point.
+
+SPDX-License-Identifier: MIT-0
+
+*/
+
+#include "sdkconfig.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <math.h>
+#include <hagl.h>
+
+#include "sineplasma.h"
+#include "span.h"
+#include "arena.h"
+#include "cache.h"
+#include "indexed.h"
+#include "fixed.h"
+
+static const uint8_t PIXEL_SIZE = CONFIG_EFFECTS_SINEPLASMA_PIXEL_SIZE;
+#ifdef CONFIG_EFFECTS_SINEPLASMA_BILINEAR
+static const uint8_t FILTER = SPAN_BILINEAR;
+#else
+static const uint8_t FILTER = SPAN_NEAREST;
+#endif
+
+/* Bump when the generated tables change. */
+static const uint32_t VERSION = 1 + FIXED_VERSION;
+
+/* Size of the effect in blocks. */
+#define BLOCKS_X    SPAN_WIDTH(PIXEL_SIZE)
+#define BLOCKS_Y    ((DISPLAY_HEIGHT + PIXEL_SIZE - 1) / PIXEL_SIZE)
+
+/* Distance table covers twice the screen in both directions. */
+#define STRIDE      (2 * BLOCKS_X)
+
+static hagl_color_t *palette;
+static uint8_t *distance;
+
+/* Palette or, with an indexed back buffer, identity which writes indices. */
+static hagl_color_t const *lookup;
+
+/* Scaled to 0 ... 85 so that three layers add up to at most 255. */
+static uint8_t sine[256];
+static uint8_t column[DISPLAY_WIDTH];
+static uint8_t row[DISPLAY_HEIGHT];
+
+/* Phase of each layer and of the radial center. */
+static uint8_t t1, t2, t3, t4, t5;
+
+/* Top left corner of the distance table window. */
+static uint16_t ox, oy;
+
+size_t
+sineplasma_arena_size()
+{
+    return ARENA_SIZE(256 * sizeof(hagl_color_t)) + ARENA_SIZE(STRIDE * 2 * BLOCKS_Y * sizeof(uint8_t));
+}
+
+void
+sineplasma_init(hagl_backend_t const *display)
+{
+    const cache_key_t distance_key = { "sineplasma", PIXEL_SIZE, VERSION };
+
+    palette = arena_alloc(256 * sizeof(hagl_color_t));
+    distance = arena_alloc(STRIDE * 2 * BLOCKS_Y * sizeof(uint8_t));
+
+    /* Palette is always in HAL colors, also when writing indices. */
+    hagl_backend_t const *hal = indexed_target(display);
+    lookup = hal ? indexed_identity() : palette;
+    if (!hal) {
+        hal = display;
+    }
+
+    /* Same continous palette as the palette plasma. */
+    for(uint16_t i = 0; i < 256; i++) {
+#ifdef CONFIG_EFFECTS_FIXED_POINT
+        const uint8_t r = 128 + ((128 * fixed_sin(i * FIXED_TURN / 256 + fixed_radians(1, 0))) >> FIXED_SINE_SHIFT);
+        const uint8_t g = 128 + ((128 * fixed_sin(i * FIXED_TURN / 128 + fixed_radians(1, 0))) >> FIXED_SINE_SHIFT);
+#else
+        const uint8_t r = 128.0f + 128.0f * sin((M_PI * i / 128.0f) + 1);
+        const uint8_t g = 128.0f + 128.0f * sin((M_PI * i / 64.0f) + 1);
+#endif /* CONFIG_EFFECTS_FIXED_POINT */
+        const uint8_t b = 64;
+        palette[i] = hagl_color(hal, r, g, b);
+    }
+
+    for (uint16_t i = 0; i < 256; i++) {
+#ifdef CONFIG_EFFECTS_FIXED_POINT
+        sine[i] = ((128 << FIXED_SINE_SHIFT) + 127 * fixed_sin(i * FIXED_TURN / 256)) / (3 << FIXED_SINE_SHIFT);
+#else
+        sine[i] = (128.0f + 127.0f * sinf(2 * M_PI * i / 256.0f)) / 3.0f;
+#endif /* CONFIG_EFFECTS_FIXED_POINT */
+    }
+
+    if (!cache_load(&distance_key, distance, STRIDE * 2 * BLOCKS_Y * sizeof(uint8_t))) {
+        /* Distance to the center of the table, one period every ~150 pixels. */
+        uint8_t *ptr = distance;
+        for (int16_t y = -BLOCKS_Y; y < BLOCKS_Y; y++) {
+            for (int16_t x = -BLOCKS_X; x < BLOCKS_X; x++) {
+                const int32_t dx = x * PIXEL_SIZE;
+                const int32_t dy = y * PIXEL_SIZE;
+                *(ptr++) = fixed_isqrt(3 * (dx * dx + dy * dy));
+            }
+        }
+        cache_store(&distance_key, distance, STRIDE * 2 * BLOCKS_Y * sizeof(uint8_t));
+    }
+
+    t1 = t2 = t3 = t4 = t5 = 0;
+}
+
+void
+sineplasma_animate()
+{
+    t1 += 3;
+    t2 -= 2;
+    t3 += 5;
+    t4 += 2;
+    t5 += 3;
+
+    /* Unsigned integers wrap automatically. */
+    for (uint16_t x = 0; x < BLOCKS_X; x++) {
+        column[x] = sine[(uint8_t) (x * PIXEL_SIZE * 5 / 4 + t1)];
+    }
+    for (uint16_t y = 0; y < BLOCKS_Y; y++) {
+        row[y] = sine[(uint8_t) (y * PIXEL_SIZE * 7 / 4 + t2)];
+    }
+
+    /* Radial center wanders over the whole screen. */
+    ox = sine[t4] * BLOCKS_X / 86;
+    oy = sine[t5] * BLOCKS_Y / 86;
+
+    if (lookup != palette) {
+        indexed_palette(palette, 0);
+    }
+}
+
+static void
+sineplasma_row(hagl_color_t *colors, uint16_t y)
+{
+    const uint8_t r = row[y];
+    const uint8_t *d = distance + (y + oy) * STRIDE + ox;
+    hagl_color_t *color = colors;
+
+    for (uint16_t x = 0; x < BLOCKS_X; x++) {
+        const uint8_t index = column[x] + r + sine[(uint8_t) (*(d++) - t3)];
+        *(color++) = lookup[index];
+    }
+}
+
+void
+sineplasma_render_rows(hagl_backend_t const *display, int16_t y0, int16_t y1)
+{
+    span_render(display, y0, y1, sineplasma_row, PIXEL_SIZE, FILTER);
+}
+
+void
+sineplasma_render(hagl_backend_t const *display)
+{
+    sineplasma_render_rows(display, SPAN_TOP(display), display->clip.y1 + 1);
+}
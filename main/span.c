@@ -0,0 +1,222 @@
+/*
+
+MIT No Attribution
+
+Copyright (c) 2023 Mika Tuupola
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+-cut-
+
+Row based output for the effects. Instead of one hagl_put_pixel() or
+hagl_fill_rectangle() call per block the effect fills a row of colors
+and the whole row is written to the back buffer with one blit.
+
+Effects rendered at low resolution only produce the small rows, this
+is also where they get scaled up to the display resolution.
+
+SPDX-License-Identifier: MIT-0
+
+*/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <hagl.h>
+
+#include "span.h"
+#include "kernel.h"
+
+/* RGB565 with gaps between channels so they can be multiplied. */
+#define SPREAD_MASK (0x07e0f81f)
+
+static inline uint32_t
+spread(hagl_color_t color, bool swap)
+{
+    if (swap) {
+        color = (color >> 8) | (color << 8);
+    }
+    return (color | (uint32_t) color << 16) & SPREAD_MASK;
+}
+
+static inline hagl_color_t
+pack(uint32_t spread, bool swap)
+{
+    const hagl_color_t color = spread | spread >> 16;
+    return swap ? (color >> 8) | (color << 8) : color;
+}
+
+/*
+ * Repeat each color size times. Called with a constant size for every
+ * supported size so each copy gets its own unrolled inner loop.
+ */
+static inline void
+expand(hagl_color_t *dst, const hagl_color_t *src, uint16_t width, uint8_t size)
+{
+    for (uint16_t blocks = width / size; blocks; blocks--) {
+        const hagl_color_t color = *(src++);
+        for (uint8_t i = 0; i < size; i++) {
+            *(dst++) = color;
+        }
+    }
+    /* Partial block at the right edge. */
+    for (uint8_t i = 0; i < width % size; i++) {
+        *(dst++) = *src;
+    }
+}
+
+/* Blend from a towards b, weight is 0 ... 32. */
+static inline uint32_t
+blend(uint32_t a, uint32_t b, uint8_t weight)
+{
+    return ((a * (32 - weight) + b * weight) >> 5) & SPREAD_MASK;
+}
+
+void
+span_put_row(hagl_backend_t const *display, int16_t y0, hagl_color_t const *colors, uint8_t size)
+{
+    int16_t y1 = y0 + size - 1;
+    int16_t x0 = display->clip.x0;
+    int16_t x1 = display->clip.x1;
+
+    /* Clip the row vertically. */
+    if (y0 < display->clip.y0) {
+        y0 = display->clip.y0;
+    }
+    if (y1 > display->clip.y1) {
+        y1 = display->clip.y1;
+    }
+    if (y0 > y1 || x0 > x1) {
+        return;
+    }
+
+    const uint16_t width = x1 - x0 + 1;
+    const uint16_t height = y1 - y0 + 1;
+    /* On stack so that both cores can write rows at the same time. */
+    hagl_color_t expanded[DISPLAY_WIDTH * SPAN_MAX_SIZE] KERNEL_ALIGNED;
+    hagl_color_t *ptr = expanded;
+    hagl_bitmap_t bitmap;
+
+    if (1 == size) {
+        /* Nothing to expand, blit straight from the callers buffer. */
+        hagl_bitmap_init(&bitmap, width, 1, DISPLAY_DEPTH, (void *) (colors + x0));
+    } else if (0 == x0 % size) {
+        switch(size) {
+            case 2:
+                /*
+                 * Most common case, double the colors with pair writes. Odd
+                 * width writes one extra pixel which the next row overwrites.
+                 */
+                kernel_double16(expanded, colors + x0 / 2, (width + 1) / 2);
+                break;
+            case 3:
+                expand(expanded, colors + x0 / 3, width, 3);
+                break;
+            default:
+                expand(expanded, colors + x0 / SPAN_MAX_SIZE, width, SPAN_MAX_SIZE);
+                break;
+        }
+    } else {
+        /* Repeat each color size times, starting from the clipped edge. */
+        const hagl_color_t *src = colors + x0 / size;
+        uint8_t repeat = size - x0 % size;
+
+        for (uint16_t x = 0; x < width; x++) {
+            *(ptr++) = *src;
+            if (0 == --repeat) {
+                src++;
+                repeat = size;
+            }
+        }
+    }
+
+    if (1 != size) {
+        /* Then repeat the whole row. */
+        for (uint16_t y = 1; y < height; y++) {
+            memcpy(expanded + y * width, expanded, width * sizeof(hagl_color_t));
+        }
+
+        hagl_bitmap_init(&bitmap, width, height, DISPLAY_DEPTH, expanded);
+    }
+
+    if (display->blit) {
+        display->blit((void *) display, x0, y0, &bitmap);
+    } else {
+        hagl_blit_xy(display, x0, y0, &bitmap);
+    }
+}
+
+void
+span_put_row_bilinear(hagl_backend_t const *display, int16_t y0, hagl_color_t const *colors, hagl_color_t const *next, uint8_t size)
+{
+    const int16_t top = y0;
+    int16_t y1 = y0 + size - 1;
+    int16_t x0 = display->clip.x0;
+    int16_t x1 = display->clip.x1;
+
+    if (y0 < display->clip.y0) {
+        y0 = display->clip.y0;
+    }
+    if (y1 > display->clip.y1) {
+        y1 = display->clip.y1;
+    }
+    if (y0 > y1 || x0 > x1) {
+        return;
+    }
+
+    const uint16_t width = x1 - x0 + 1;
+    const uint16_t height = y1 - y0 + 1;
+    const uint16_t blocks = SPAN_WIDTH(size);
+    /* Blending is done in RGB order, HAL may store colors swapped. */
+    const bool swap = 0x001f != hagl_color(display, 0, 0, 255);
+    uint32_t mixed[DISPLAY_WIDTH + 1];
+    uint8_t weights[SPAN_MAX_SIZE];
+    hagl_color_t expanded[DISPLAY_WIDTH * SPAN_MAX_SIZE] KERNEL_ALIGNED;
+    hagl_color_t *ptr = expanded;
+    hagl_bitmap_t bitmap;
+
+    for (uint8_t k = 0; k < size; k++) {
+        weights[k] = k * 32 / size;
+    }
+
+    for (int16_t y = y0; y <= y1; y++) {
+        /* First blend the two rows, then neighbouring colors. */
+        const uint8_t weight = weights[y - top];
+        for (uint16_t i = 0; i < blocks; i++) {
+            mixed[i] = blend(spread(colors[i], swap), spread(next[i], swap), weight);
+        }
+        /* Last color blends with itself. */
+        mixed[blocks] = mixed[blocks - 1];
+
+        const uint32_t *left = mixed + x0 / size;
+        uint8_t k = x0 % size;
+        for (int16_t x = x0; x <= x1; x++) {
+            *(ptr++) = pack(blend(left[0], left[1], weights[k]), swap);
+            if (++k == size) {
+                k = 0;
+                left++;
+            }
+        }
+    }
+
+    hagl_bitmap_init(&bitmap, width, height, DISPLAY_DEPTH, expanded);
+
+    if (display->blit) {
+        display->blit((void *) display, x0, y0, &bitmap);
+    } else {
+        hagl_blit_xy(display, x0, y0, &bitmap);
+    }
+}
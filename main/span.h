@@ -0,0 +1,126 @@
+/*
+
+MIT No Attribution
+
+Copyright (c) 2023 Mika Tuupola
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+-cut-
+
+SPDX-License-Identifier: MIT-0
+
+*/
+
+#ifndef _SPAN_H
+#define _SPAN_H
+
+#include <stdint.h>
+#include <hagl.h>
+
+#include "kernel.h"
+
+/* Largest supported block size for span_put_row(). */
+#define SPAN_MAX_SIZE   (4)
+
+/*
+ * Number of colors needed for one row when each color covers a size x
+ * size block of pixels.
+ */
+#define SPAN_WIDTH(size) ((DISPLAY_WIDTH + (size) - 1) / (size))
+
+/* First row at or after y which starts a new size x size block. */
+#define SPAN_ALIGN(y, size) ((((y) + (size) - 1) / (size)) * (size))
+
+/* Multiple of every supported block size. */
+#define SPAN_ALIGN_ALL  (12)
+
+/*
+ * First row to render from so that blocks of any size which cover the
+ * top of the clip window are rendered too. Rows above the clip window
+ * are reserved for texts and are never written.
+ */
+#define SPAN_TOP(display) ((display)->clip.y0 - (display)->clip.y0 % SPAN_ALIGN_ALL)
+
+/* How low resolution rows are scaled up to the display. */
+enum {
+    SPAN_NEAREST = 0,
+    SPAN_BILINEAR
+};
+
+/*
+ * Fills colors with row number row of an effect rendered at low
+ * resolution, SPAN_WIDTH(size) colors. Must not depend on the order
+ * rows are requested in.
+ */
+typedef void span_row_t(hagl_color_t *colors, uint16_t row);
+
+/*
+ * Write one row of colors to the back buffer with a single blit. Each
+ * color is repeated size times horizontally and the resulting row size
+ * times vertically starting from y0. Output is clipped to the clip
+ * window of the display. Safe to call from several tasks at once.
+ */
+void span_put_row(hagl_backend_t const *display, int16_t y0, hagl_color_t const *colors, uint8_t size);
+
+/*
+ * Same as above but blends between neighbouring colors horizontally
+ * and towards the next row vertically. Expects RGB565 colors.
+ */
+void span_put_row_bilinear(hagl_backend_t const *display, int16_t y0, hagl_color_t const *colors, hagl_color_t const *next, uint8_t size);
+
+/*
+ * Render display rows y0 ... y1 - 1 of an effect which is rendered at
+ * 1 / size resolution. Low resolution rows are requested one by one
+ * and scaled up with the given filter. Bilinear filter requests one
+ * extra row below the range. Inline so that the row function gets
+ * inlined into the loop.
+ */
+static inline void
+span_render(hagl_backend_t const *display, int16_t y0, int16_t y1, span_row_t *row, uint8_t size, uint8_t filter)
+{
+    const uint16_t rows = (DISPLAY_HEIGHT + size - 1) / size;
+    hagl_color_t upper[DISPLAY_WIDTH] KERNEL_ALIGNED;
+    hagl_color_t lower[DISPLAY_WIDTH] KERNEL_ALIGNED;
+    hagl_color_t *current = upper;
+    hagl_color_t *below = lower;
+    uint16_t y = SPAN_ALIGN(y0, size);
+
+    if (SPAN_NEAREST == filter) {
+        for (; y < y1; y += size) {
+            row(current, y / size);
+            span_put_row(display, y, current, size);
+        }
+        return;
+    }
+
+    if (y < y1) {
+        row(current, y / size);
+    }
+    for (; y < y1; y += size) {
+        /* Last row blends with itself. */
+        const uint16_t next = y / size + 1 < rows ? y / size + 1 : y / size;
+        row(below, next);
+        span_put_row_bilinear(display, y, current, below, size);
+
+        /* Row below is the upper row of the next round. */
+        hagl_color_t *swap = current;
+        current = below;
+        below = swap;
+    }
+}
+
+#endif /* _SPAN_H */
@@ -0,0 +1,219 @@
+/*
+
+MIT No Attribution
+
+Copyright (c) 2020-2023 Mika Tuupola
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+
+-cut-
+
+Renders the frame a few lines at a time. While one strip is sent over
+SPI the next one is rendered into another buffer, so a HAL without
+any back buffer can be used. A full frame buffer is never allocated,
+which leaves the memory for lookup tables and textures.
+
+SPDX-License-Identifier: MIT-0
+
+*/
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <hagl.h>
+
+#ifdef ESP_PLATFORM
+#include <esp_heap_caps.h>
+#endif /* ESP_PLATFORM */
+
+#include "strip.h"
+#include "blit.h"
+
+static hagl_backend_t backend;
+static hagl_backend_t *target;
+static hagl_window_t window;
+static uint16_t lines;
+static int16_t first;
+
+static uint8_t *buffers[STRIP_SLOTS];
+/* Display row of the first line of the strip in each slot. */
+static int16_t offset[STRIP_SLOTS];
+/* Rows of the strip which are inside the clip window. */
+static int16_t top[STRIP_SLOTS];
+static int16_t bottom[STRIP_SLOTS];
+static uint8_t current;
+
+static inline hagl_color_t *
+pixel(int16_t x0, int16_t y0)
+{
+    return (hagl_color_t *) backend.buffer + DISPLAY_WIDTH * (y0 - offset[current]) + x0;
+}
+
+static void
+put_pixel(void *self, int16_t x0, int16_t y0, hagl_color_t color)
+{
+    *pixel(x0, y0) = color;
+}
+
+static hagl_color_t
+get_pixel(void *self, int16_t x0, int16_t y0)
+{
+    return *pixel(x0, y0);
+}
+
+static hagl_color_t
+color(void *self, uint8_t r, uint8_t g, uint8_t b)
+{
+    return hagl_color(target, r, g, b);
+}
+
+static void
+blit(void *self, int16_t x0, int16_t y0, hagl_bitmap_t *src)
+{
+    hagl_color_t *dst = pixel(x0, y0);
+    const size_t size = src->width * sizeof(hagl_color_t);
+    uint8_t *ptr = src->buffer;
+
+    for (int16_t y = 0; y < src->height; y++) {
+        memcpy(dst, ptr, size);
+        dst += DISPLAY_WIDTH;
+        ptr += src->pitch;
+    }
+}
+
+static void
+hline(void *self, int16_t x0, int16_t y0, uint16_t width, hagl_color_t color)
+{
+    hagl_color_t *ptr = pixel(x0, y0);
+
+    while (width--) {
+        *(ptr++) = color;
+    }
+}
+
+static void
+vline(void *self, int16_t x0, int16_t y0, uint16_t height, hagl_color_t color)
+{
+    hagl_color_t *ptr = pixel(x0, y0);
+
+    while (height--) {
+        *ptr = color;
+        ptr += DISPLAY_WIDTH;
+    }
+}
+
+static size_t
+flush(void *self)
+{
+    /* Strips are sent with strip_send() as soon as they are rendered. */
+    return 0;
+}
+
+static void
+close(void *self)
+{
+    for (uint8_t i = 0; i < STRIP_SLOTS; i++) {
+        free(buffers[i]);
+        buffers[i] = NULL;
+    }
+    hagl_close(target);
+}
+
+hagl_backend_t *
+strip_init(hagl_backend_t *hal, uint16_t height)
+{
+    const size_t size = DISPLAY_WIDTH * height * sizeof(hagl_color_t);
+
+    memset(&backend, 0, sizeof(hagl_backend_t));
+
+    for (uint8_t i = 0; i < STRIP_SLOTS; i++) {
+#ifdef ESP_PLATFORM
+        /* SPI master can send straight from DMA capable memory. */
+        buffers[i] = heap_caps_malloc(size, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+#else
+        buffers[i] = malloc(size);
+#endif /* ESP_PLATFORM */
+        if (NULL == buffers[i]) {
+            while (i--) {
+                free(buffers[i]);
+                buffers[i] = NULL;
+            }
+            return NULL;
+        }
+    }
+
+    target = hal;
+    window = hal->clip;
+    lines = height;
+    /* First strip is aligned, it may start above the clip window. */
+    first = SPAN_TOP(hal);
+    current = 0;
+
+    backend.width = DISPLAY_WIDTH;
+    backend.height = DISPLAY_HEIGHT;
+    backend.depth = DISPLAY_DEPTH;
+    backend.put_pixel = put_pixel;
+    backend.get_pixel = get_pixel;
+    backend.color = color;
+    backend.blit = blit;
+    backend.hline = hline;
+    backend.vline = vline;
+    backend.flush = flush;
+    backend.close = close;
+    backend.buffer = buffers[0];
+    backend.clip = window;
+
+    return &backend;
+}
+
+uint16_t
+strip_count()
+{
+    return (window.y1 + 1 - first + lines - 1) / lines;
+}
+
+void
+strip_begin(uint8_t slot, uint16_t index, int16_t *y0, int16_t *y1)
+{
+    *y0 = first + index * lines;
+    *y1 = *y0 + lines < window.y1 + 1 ? *y0 + lines : window.y1 + 1;
+
+    current = slot;
+    offset[slot] = *y0;
+    top[slot] = *y0 > window.y0 ? *y0 : window.y0;
+    bottom[slot] = *y1;
+
+    /* Effects clip their output to the strip. */
+    backend.buffer = buffers[slot];
+    backend.clip.x0 = window.x0;
+    backend.clip.y0 = top[slot];
+    backend.clip.x1 = window.x1;
+    backend.clip.y1 = bottom[slot] - 1;
+}
+
+size_t
+strip_send(uint8_t slot)
+{
+    hagl_bitmap_t bitmap;
+    uint8_t *buffer = buffers[slot] + DISPLAY_WIDTH * (top[slot] - offset[slot]) * sizeof(hagl_color_t);
+
+    /* Full width rows are contiguous in memory, one DMA transfer. */
+    hagl_bitmap_init(&bitmap, DISPLAY_WIDTH, bottom[slot] - top[slot], DISPLAY_DEPTH, buffer);
+    blit_rows(target, top[slot], &bitmap);
+
+    return bitmap.size;
+}
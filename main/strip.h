@@ -0,0 +1,72 @@
+/*
+
+MIT No Attribution
+
+Copyright (c) 2020-2023 Mika Tuupola
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+
+-cut-
+
+SPDX-License-Identifier: MIT-0
+
+*/
+
+#ifndef _STRIP_H
+#define _STRIP_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <hagl.h>
+
+#include "span.h"
+
+/* One strip is sent while the other one is rendered. */
+#define STRIP_SLOTS     (2)
+
+/*
+ * Strips start on multiples of this so that blocks of every supported
+ * pixel size start and end inside one strip.
+ */
+#define STRIP_ALIGN     (SPAN_ALIGN_ALL)
+
+/*
+ * Wrap a HAL which has no back buffer. Returns a backend which renders
+ * into one of STRIP_SLOTS buffers, each height lines tall. Height must
+ * be a multiple of STRIP_ALIGN. Strips cover the clip window the HAL
+ * has when this is called and are sent full width. Returns NULL if out
+ * of memory.
+ */
+hagl_backend_t *strip_init(hagl_backend_t *hal, uint16_t height);
+
+/* Number of strips in one frame. */
+uint16_t strip_count();
+
+/*
+ * Point the backend to the buffer in slot for the strip with given
+ * index. Rows y0 ... y1 - 1 should then be rendered.
+ */
+void strip_begin(uint8_t slot, uint16_t index, int16_t *y0, int16_t *y1);
+
+/*
+ * Send the strip in slot to the HAL. Blocks until the transfer has
+ * completed and returns the number of bytes sent. Safe to call while
+ * the next strip is rendered into another slot.
+ */
+size_t strip_send(uint8_t slot);
+
+#endif /* _STRIP_H */